@@ -2,10 +2,220 @@
  * @file AST.cpp
  * @brief Implements the concrete methods for the Abstract Syntax Tree (AST) nodes.
  *
- * This file contains the implementation details for:
- * 1. Constructors for all AST node types (IntNode, VarNode, etc.).
- * 2. The Evaluate method for computing the numerical result of an expression given an environment.
- * 3. The Normalize method, which is critical for the Simple Equality Judgment. This method handles
- * the canonical representation of expressions, including the commutative and associative properties
- * of addition and multiplication, and special expansion of powers (x^2, x^3).
- */
\ No newline at end of file
+ * Tree printing is written as a visitor over visitNode(), the same dispatch mechanism
+ * used by EqualityChecker::standardize, so node types are never probed with RTTI.
+ * Printing and sameStructure() keep pending subtrees on an explicit stack instead of
+ * recursing, so they work on trees of any depth.
+ */
+#include "AST.h"
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+
+// 打印时使用的运算符/函数名
+const char *opName(TokenType op)
+{
+    switch (op)
+    {
+    case TokenType::PLUS:
+        return "+";
+    case TokenType::MINUS:
+        return "-";
+    case TokenType::MUL:
+        return "*";
+    case TokenType::DIV:
+        return "/";
+    case TokenType::POW:
+        return "^";
+    default:
+        return "?";
+    }
+}
+
+const char *funcName(TokenType funcType)
+{
+    switch (funcType)
+    {
+    case TokenType::SIN:
+        return "sin";
+    case TokenType::COS:
+        return "cos";
+    case TokenType::TAN:
+        return "tan";
+    case TokenType::COT:
+        return "cot";
+    case TokenType::LN:
+        return "ln";
+    case TokenType::SQRT:
+        return "sqrt";
+    default:
+        return "func";
+    }
+}
+
+// 先序打印一个节点；子树不递归打印，而是按 (节点, 缩进) 压入 pending，由 print() 逐个弹出
+struct Printer
+{
+    std::ostream &out;
+    std::vector<std::pair<const ASTNode *, int>> &pending;
+    int indent;
+
+    void pad() const
+    {
+        // 深层树的缩进很长，分块写出，不构造临时字符串
+        static const char spaces[] = "                                                                ";
+        for (size_t left = size_t(indent) * 2; left > 0;)
+        {
+            size_t n = std::min(left, sizeof(spaces) - 1);
+            out.write(spaces, static_cast<std::streamsize>(n));
+            left -= n;
+        }
+    }
+
+    void operator()(const NumberNode &n) const
+    {
+        pad();
+        out << "Num: " << n.value << '\n';
+    }
+    void operator()(const VariableNode &v) const
+    {
+        pad();
+        out << "Var: " << v.name << '\n';
+    }
+    void operator()(const UnaryOpNode &u) const
+    {
+        pad();
+        out << "UnaryOp: " << (u.op == TokenType::MINUS ? "-" : "") << '\n';
+        pending.emplace_back(u.right.get(), indent + 1);
+    }
+    void operator()(const BinaryOpNode &b) const
+    {
+        pad();
+        out << "BinaryOp: " << opName(b.op) << '\n';
+        // 后入栈的先打印
+        pending.emplace_back(b.right.get(), indent + 1);
+        pending.emplace_back(b.left.get(), indent + 1);
+    }
+    void operator()(const FunctionNode &f) const
+    {
+        pad();
+        out << "Function: " << funcName(f.funcType) << '\n';
+        pending.emplace_back(f.arg.get(), indent + 1);
+    }
+};
+
+// 当前线程正在递归析构的层数
+thread_local int releaseDepth = 0;
+constexpr int kMaxRecursiveRelease = 256;
+
+} // namespace
+
+void ASTNode::print(int indent) const
+{
+    print(std::cout, indent);
+}
+
+void ASTNode::print(std::ostream &out, int indent) const
+{
+    std::vector<std::pair<const ASTNode *, int>> pending{{this, indent}};
+    while (!pending.empty())
+    {
+        auto [node, level] = pending.back();
+        pending.pop_back();
+        visitNode(*node, Printer{out, pending, level});
+    }
+}
+
+void ASTNode::releaseSubtree(std::shared_ptr<ASTNode> &child)
+{
+    // 浅层直接递归析构（常见情况，最快），超过一定深度后才改用显式栈
+    if (releaseDepth < kMaxRecursiveRelease)
+    {
+        ++releaseDepth;
+        child.reset();
+        --releaseDepth;
+        return;
+    }
+    std::vector<std::shared_ptr<ASTNode>> pending;
+    pending.push_back(std::move(child));
+    while (!pending.empty())
+    {
+        std::shared_ptr<ASTNode> node = std::move(pending.back());
+        pending.pop_back();
+        if (node.use_count() != 1)
+            continue;
+        // 先把子节点移到栈上，node 析构时就没有子树可递归了
+        switch (node->kind)
+        {
+        case NodeKind::UnaryOp:
+            pending.push_back(std::move(static_cast<UnaryOpNode &>(*node).right));
+            break;
+        case NodeKind::BinaryOp:
+            pending.push_back(std::move(static_cast<BinaryOpNode &>(*node).left));
+            pending.push_back(std::move(static_cast<BinaryOpNode &>(*node).right));
+            break;
+        case NodeKind::Function:
+            pending.push_back(std::move(static_cast<FunctionNode &>(*node).arg));
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+bool sameStructure(const ASTNode &a, const ASTNode &b)
+{
+    // 待比较的节点对放在显式栈中，深层树不会压满调用栈
+    std::vector<std::pair<const ASTNode *, const ASTNode *>> pending{{&a, &b}};
+    while (!pending.empty())
+    {
+        auto [x, y] = pending.back();
+        pending.pop_back();
+        if (x == y)
+            continue;
+        if (x->kind != y->kind || x->hash != y->hash)
+            return false;
+        switch (x->kind)
+        {
+        case NodeKind::Number:
+            if (static_cast<const NumberNode &>(*x).value != static_cast<const NumberNode &>(*y).value)
+                return false;
+            break;
+        case NodeKind::Variable:
+            if (static_cast<const VariableNode &>(*x).name != static_cast<const VariableNode &>(*y).name)
+                return false;
+            break;
+        case NodeKind::UnaryOp:
+        {
+            const auto &ux = static_cast<const UnaryOpNode &>(*x);
+            const auto &uy = static_cast<const UnaryOpNode &>(*y);
+            if (ux.op != uy.op)
+                return false;
+            pending.emplace_back(ux.right.get(), uy.right.get());
+            break;
+        }
+        case NodeKind::BinaryOp:
+        {
+            const auto &bx = static_cast<const BinaryOpNode &>(*x);
+            const auto &by = static_cast<const BinaryOpNode &>(*y);
+            if (bx.op != by.op)
+                return false;
+            pending.emplace_back(bx.right.get(), by.right.get());
+            pending.emplace_back(bx.left.get(), by.left.get());
+            break;
+        }
+        case NodeKind::Function:
+        {
+            const auto &fx = static_cast<const FunctionNode &>(*x);
+            const auto &fy = static_cast<const FunctionNode &>(*y);
+            if (fx.funcType != fy.funcType)
+                return false;
+            pending.emplace_back(fx.arg.get(), fy.arg.get());
+            break;
+        }
+        }
+    }
+    return true;
+}
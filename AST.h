@@ -1,22 +1,102 @@
 /**
  * @file AST.h
  * @brief Defines the Abstract Syntax Tree (AST) node structures.
+ *
+ * Every node carries a NodeKind tag. Passes over the tree dispatch on that tag through
+ * visitNode() instead of dynamic_cast, so no RTTI lookup or shared_ptr refcount traffic
+ * happens per node. Every node also carries a structural hash computed from its children
+ * at construction time, used by NodeFactory for hash-consing.
+ *
+ * Destroying a tree does not recurse: operator nodes hand their uniquely owned children to
+ * an explicit stack (see ASTNode::release), so arbitrarily deep trees can be freed. Passes
+ * that need every child before their parent use walkPostOrder(), which keeps its frames on
+ * the heap, so tree depth is limited by memory rather than by the native stack.
  */
 #ifndef AST_H
 #define AST_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <memory>
+#include <stdexcept>
 #include <vector>
 #include "Lexer.h"
 
+// 节点种类标签，shared_ptr 树和 AstArena 共用
+enum class NodeKind
+{
+    Number,
+    Variable,
+    UnaryOp,
+    BinaryOp,
+    Function
+};
+
+// 结构哈希：只依赖节点种类、运算符、文本和子节点的哈希，与地址无关
+inline std::size_t hashMix(std::size_t h, std::size_t v)
+{
+    std::uint64_t x = static_cast<std::uint64_t>(h) ^ (static_cast<std::uint64_t>(v) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2));
+    x ^= x >> 31;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 29;
+    return static_cast<std::size_t>(x);
+}
+
+inline std::size_t hashText(std::string_view text)
+{
+    // FNV-1a，保证不同进程间结果一致
+    std::uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : text)
+    {
+        h ^= c;
+        h *= 0x100000001b3ULL;
+    }
+    return static_cast<std::size_t>(h);
+}
+
+// 叶子节点（Number / Variable）与运算节点的结构哈希，一元节点的 left 取 0
+inline std::size_t leafHash(NodeKind kind, std::string_view text)
+{
+    return hashMix(static_cast<std::size_t>(kind), hashText(text));
+}
+
+inline std::size_t opHash(NodeKind kind, TokenType op, std::size_t left, std::size_t right)
+{
+    return hashMix(hashMix(hashMix(static_cast<std::size_t>(kind), static_cast<std::size_t>(op)), left), right);
+}
+
 class ASTNode
 {
 public:
+    const NodeKind kind;
+    const std::size_t hash; // 结构哈希，结构相同的子树哈希相同
+
     virtual ~ASTNode() = default;
     // 用于打印树状结构，indent 表示缩进层级
-    virtual void print(int indent = 0) const = 0;
+    void print(int indent = 0) const;
+    // 输出到指定的流；每行以 '\n' 结尾，不逐行刷新
+    void print(std::ostream &out, int indent = 0) const;
+
+protected:
+    ASTNode(NodeKind kind, std::size_t hash) : kind(kind), hash(hash) {}
+
+    static std::size_t childHash(const std::shared_ptr<ASTNode> &child)
+    {
+        return child ? child->hash : 0;
+    }
+
+    // 运算节点析构时调用：child 是最后一个持有者时由 releaseSubtree 释放整棵子树，
+    // 深度很大的树（如 -----x）析构时不会递归压满调用栈
+    static void release(std::shared_ptr<ASTNode> &child)
+    {
+        // 叶子和仍被共享的子树直接交给 shared_ptr 处理
+        if (child && child.use_count() == 1 && child->kind >= NodeKind::UnaryOp)
+            releaseSubtree(child);
+    }
+    static void releaseSubtree(std::shared_ptr<ASTNode> &child);
 };
 
 // 整数节点
@@ -24,12 +104,9 @@ class NumberNode : public ASTNode
 {
 public:
     std::string value;
-    explicit NumberNode(std::string val) : value(val) {}
-
-    void print(int indent) const override
-    {
-        std::cout << std::string(indent * 2, ' ') << "Num: " << value << std::endl;
-    }
+    explicit NumberNode(std::string_view val)
+        : ASTNode(NodeKind::Number, leafHash(NodeKind::Number, val)),
+          value(val) {}
 };
 
 // 变量节点
@@ -37,12 +114,9 @@ class VariableNode : public ASTNode
 {
 public:
     std::string name;
-    explicit VariableNode(std::string n) : name(n) {}
-
-    void print(int indent) const override
-    {
-        std::cout << std::string(indent * 2, ' ') << "Var: " << name << std::endl;
-    }
+    explicit VariableNode(std::string_view n)
+        : ASTNode(NodeKind::Variable, leafHash(NodeKind::Variable, n)),
+          name(n) {}
 };
 
 // 一元运算符
@@ -53,21 +127,9 @@ public:
     std::shared_ptr<ASTNode> right;
 
     UnaryOpNode(TokenType op, std::shared_ptr<ASTNode> operand)
-        : op(op), right(std::move(operand)) {}
-
-    void print(int indent) const override
-    {
-        std::string opStr;
-        switch (op){
-        case TokenType::MINUS:
-            opStr = "-";
-            break;
-        default:              
-            break;
-        }
-        std::cout << std::string(indent * 2, ' ') << "UnaryOp: " << opStr << std::endl;
-        right->print(indent + 1);
-    }
+        : ASTNode(NodeKind::UnaryOp, opHash(NodeKind::UnaryOp, op, 0, childHash(operand))),
+          op(op), right(std::move(operand)) {}
+    ~UnaryOpNode() override { release(right); }
 };
 
 // 二元运算符
@@ -79,35 +141,12 @@ public:
     std::shared_ptr<ASTNode> right;
 
     BinaryOpNode(TokenType op, std::shared_ptr<ASTNode> l, std::shared_ptr<ASTNode> r)
-        : op(op), left(std::move(l)), right(std::move(r)) {}
-
-    void print(int indent) const override
+        : ASTNode(NodeKind::BinaryOp, opHash(NodeKind::BinaryOp, op, childHash(l), childHash(r))),
+          op(op), left(std::move(l)), right(std::move(r)) {}
+    ~BinaryOpNode() override
     {
-        std::string opStr;
-        switch (op)
-        {
-        case TokenType::PLUS:
-            opStr = "+";
-            break;
-        case TokenType::MINUS:
-            opStr = "-";
-            break;
-        case TokenType::MUL:
-            opStr = "*";
-            break;
-        case TokenType::DIV:
-            opStr = "/";
-            break;
-        case TokenType::POW:
-            opStr = "^";
-            break;
-        default:
-            opStr = "?";
-            break;
-        }
-        std::cout << std::string(indent * 2, ' ') << "BinaryOp: " << opStr << std::endl;
-        left->print(indent + 1);
-        right->print(indent + 1);
+        release(left);
+        release(right);
     }
 };
 
@@ -119,38 +158,139 @@ public:
     std::shared_ptr<ASTNode> arg;
 
     FunctionNode(TokenType type, std::shared_ptr<ASTNode> argument)
-        : funcType(type), arg(std::move(argument)) {}
+        : ASTNode(NodeKind::Function, opHash(NodeKind::Function, type, 0, childHash(argument))),
+          funcType(type), arg(std::move(argument)) {}
+    ~FunctionNode() override { release(arg); }
+};
+
+// 判断两棵子树结构是否相同；指向同一节点（如同一 NodeFactory 产生）时 O(1) 返回
+bool sameStructure(const ASTNode &a, const ASTNode &b);
+
+// 按 kind 分派到 visitor 对应的 operator() 重载，代替 dynamic_cast 链
+// visitor 需要为五种节点各提供一个重载，且返回类型相同
+template <typename Visitor>
+decltype(auto) visitNode(const ASTNode &node, Visitor &&visitor)
+{
+    switch (node.kind)
+    {
+    case NodeKind::Number:
+        return visitor(static_cast<const NumberNode &>(node));
+    case NodeKind::Variable:
+        return visitor(static_cast<const VariableNode &>(node));
+    case NodeKind::UnaryOp:
+        return visitor(static_cast<const UnaryOpNode &>(node));
+    case NodeKind::BinaryOp:
+        return visitor(static_cast<const BinaryOpNode &>(node));
+    case NodeKind::Function:
+        return visitor(static_cast<const FunctionNode &>(node));
+    }
+    throw std::runtime_error("Unsupported node type");
+}
+
+// 线程内复用的工作栈（遍历、标准化、概率判等和解析器都用它）：构造时取走本线程缓存的缓冲区，
+// 析构时清空后放回，预热后不再为栈分配内存。嵌套使用（遍历中又开始另一次遍历）时内层取到空缓冲区，
+// 互不影响；处理极深的树后缓冲区很大（容量超过 kMaxCached），这时直接释放，不留在缓存中
+template <typename T>
+class ScratchVector
+{
+public:
+    ScratchVector() : items(std::move(cache())) {}
+    ~ScratchVector()
+    {
+        if (items.capacity() > kMaxCached)
+            return;
+        items.clear();
+        cache() = std::move(items);
+    }
+    ScratchVector(const ScratchVector &) = delete;
+    ScratchVector &operator=(const ScratchVector &) = delete;
+
+    std::vector<T> items;
+
+private:
+    static constexpr std::size_t kMaxCached = 4096;
 
-    void print(int indent) const override
+    static std::vector<T> &cache()
     {
-        std::string funcName;
-        switch (funcType)
+        thread_local std::vector<T> buffer;
+        return buffer;
+    }
+};
+
+// 非递归的后序遍历，调用栈深度与树高无关。
+// enter(node) 在进入子树前调用，返回 false 时跳过整个子树（不再调用 leave）；
+// leave(node) 在该节点的全部子节点 leave 之后调用，左子树先于右子树完成
+template <typename Enter, typename Leave>
+void walkPostOrder(const ASTNode &root, Enter &&enter, Leave &&leave)
+{
+    struct Frame
+    {
+        const ASTNode *node;
+        bool expanded; // 子节点已入栈，再次到达栈顶时调用 leave
+    };
+    ScratchVector<Frame> scratch;
+    std::vector<Frame> &stack = scratch.items;
+    stack.push_back({&root, false});
+    while (!stack.empty())
+    {
+        Frame &top = stack.back();
+        const ASTNode *node = top.node;
+        if (top.expanded)
         {
-        case TokenType::SIN:
-            funcName = "sin";
-            break;
-        case TokenType::COS:
-            funcName = "cos";
-            break;
-        case TokenType::TAN:
-            funcName = "tan";
-            break;
-        case TokenType::COT:
-            funcName = "cot";
+            stack.pop_back();
+            leave(*node);
+            continue;
+        }
+        if (!enter(*node))
+        {
+            stack.pop_back();
+            continue;
+        }
+        top.expanded = true;
+        // 叶子子节点就地进入并离开，不占用栈帧；其余子节点逆序入栈。
+        // 左子节点是叶子时先处理它，右子树仍在它之后完成，顺序不变
+        auto isLeaf = [](const ASTNode *n) { return n->kind == NodeKind::Number || n->kind == NodeKind::Variable; };
+        auto visitLeaf = [&](const ASTNode *leaf) {
+            if (enter(*leaf))
+                leave(*leaf);
+        };
+        const ASTNode *first = nullptr;
+        const ASTNode *second = nullptr;
+        switch (node->kind)
+        {
+        case NodeKind::UnaryOp:
+            first = static_cast<const UnaryOpNode *>(node)->right.get();
             break;
-        case TokenType::LN:
-            funcName = "ln";
+        case NodeKind::BinaryOp:
+            first = static_cast<const BinaryOpNode *>(node)->left.get();
+            second = static_cast<const BinaryOpNode *>(node)->right.get();
             break;
-        case TokenType::SQRT:
-            funcName = "sqrt";
+        case NodeKind::Function:
+            first = static_cast<const FunctionNode *>(node)->arg.get();
             break;
         default:
-            funcName = "func";
             break;
         }
-        std::cout << std::string(indent * 2, ' ') << "Function: " << funcName << std::endl;
-        arg->print(indent + 1);
+        if (first && !isLeaf(first))
+        {
+            if (second)
+                stack.push_back({second, false});
+            stack.push_back({first, false});
+            continue;
+        }
+        if (first)
+            visitLeaf(first);
+        if (second && !isLeaf(second))
+        {
+            stack.push_back({second, false});
+            continue;
+        }
+        if (second)
+            visitLeaf(second);
+        // 所有子节点都已完成
+        stack.pop_back();
+        leave(*node);
     }
-};
+}
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,56 @@
+/**
+ * @file AstArena.cpp
+ * @brief Implements node allocation for the flat arena AST.
+ */
+#include "AstArena.h"
+
+NodeId AstArena::push(NodeKind kind, TokenType op, NodeId left, NodeId right, std::string_view text)
+{
+    FlatNode n;
+    n.kind = kind;
+    n.op = op;
+    n.left = left;
+    n.right = right;
+    n.textOffset = static_cast<std::uint32_t>(chars.size());
+    n.textLength = static_cast<std::uint32_t>(text.size());
+    chars.append(text.data(), text.size());
+    nodes.push_back(n);
+    return static_cast<NodeId>(nodes.size() - 1);
+}
+
+NodeId AstArena::addNumber(std::string_view value)
+{
+    return push(NodeKind::Number, TokenType::INT, kNullNode, kNullNode, value);
+}
+
+NodeId AstArena::addVariable(std::string_view name)
+{
+    return push(NodeKind::Variable, TokenType::VAR, kNullNode, kNullNode, name);
+}
+
+NodeId AstArena::addUnary(TokenType op, NodeId operand)
+{
+    return push(NodeKind::UnaryOp, op, kNullNode, operand, {});
+}
+
+NodeId AstArena::addBinary(TokenType op, NodeId left, NodeId right)
+{
+    return push(NodeKind::BinaryOp, op, left, right, {});
+}
+
+NodeId AstArena::addFunction(TokenType funcType, NodeId arg)
+{
+    return push(NodeKind::Function, funcType, kNullNode, arg, {});
+}
+
+void AstArena::reserve(size_t nodeCount, size_t charCount)
+{
+    nodes.reserve(nodeCount);
+    chars.reserve(charCount);
+}
+
+void AstArena::clear()
+{
+    nodes.clear();
+    chars.clear();
+}
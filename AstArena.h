@@ -0,0 +1,100 @@
+/**
+ * @file AstArena.h
+ * @brief Declares a flat, index-addressed AST stored in a per-parse arena.
+ *
+ * The shared_ptr tree in AST.h allocates every node (plus a control block) separately.
+ * AstArena keeps all nodes of one parse in a single contiguous vector and addresses
+ * children by NodeId, and keeps the text of numbers and variables in one character pool.
+ * Everything is released at once by clear() or by destroying the arena; clear() keeps
+ * the capacity, so reusing one arena for many parses stops allocating after warm-up.
+ */
+#ifndef AST_ARENA_H
+#define AST_ARENA_H
+
+#include "AST.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using NodeId = std::uint32_t;
+constexpr NodeId kNullNode = UINT32_MAX;
+
+// 扁平节点：子节点用下标引用，不持有任何堆内存
+struct FlatNode
+{
+    NodeKind kind;
+    TokenType op;      // UnaryOp / BinaryOp 的运算符，Function 的函数类型
+    NodeId left;       // BinaryOp 的左操作数
+    NodeId right;      // UnaryOp / BinaryOp 的右操作数，Function 的参数
+    std::uint32_t textOffset; // Number / Variable 的文本在字符池中的位置
+    std::uint32_t textLength;
+};
+
+class AstArena
+{
+public:
+    NodeId addNumber(std::string_view value);
+    NodeId addVariable(std::string_view name);
+    NodeId addUnary(TokenType op, NodeId operand);
+    NodeId addBinary(TokenType op, NodeId left, NodeId right);
+    NodeId addFunction(TokenType funcType, NodeId arg);
+
+    const FlatNode &operator[](NodeId id) const { return nodes[id]; }
+    // Number 的数值或 Variable 的名字
+    std::string_view text(NodeId id) const
+    {
+        const FlatNode &n = nodes[id];
+        return std::string_view(chars.data() + n.textOffset, n.textLength);
+    }
+
+    size_t size() const { return nodes.size(); }
+    void reserve(size_t nodeCount, size_t charCount);
+    // 一次性释放所有节点，保留容量以便下一次解析复用
+    void clear();
+
+private:
+    std::vector<FlatNode> nodes;
+    std::string chars;
+
+    NodeId push(NodeKind kind, TokenType op, NodeId left, NodeId right, std::string_view text);
+};
+
+// 与 AST.h 中的 walkPostOrder 相同的非递归后序遍历，回调的参数是 NodeId
+template <typename Enter, typename Leave>
+void walkPostOrder(const AstArena &arena, NodeId root, Enter &&enter, Leave &&leave)
+{
+    struct Frame
+    {
+        NodeId id;
+        bool expanded;
+    };
+    ScratchVector<Frame> scratch;
+    std::vector<Frame> &stack = scratch.items;
+    stack.push_back({root, false});
+    while (!stack.empty())
+    {
+        Frame &top = stack.back();
+        NodeId id = top.id;
+        if (top.expanded)
+        {
+            stack.pop_back();
+            leave(id);
+            continue;
+        }
+        if (!enter(id))
+        {
+            stack.pop_back();
+            continue;
+        }
+        top.expanded = true;
+        const FlatNode &node = arena[id];
+        // UnaryOp 和 Function 的操作数都在 right 中
+        if (node.kind == NodeKind::BinaryOp || node.kind == NodeKind::UnaryOp || node.kind == NodeKind::Function)
+            stack.push_back({node.right, false});
+        if (node.kind == NodeKind::BinaryOp)
+            stack.push_back({node.left, false});
+    }
+}
+
+#endif
@@ -0,0 +1,177 @@
+/**
+ * @file BatchRunner.cpp
+ * @brief Implements the thread-pool batch comparison of expression pairs.
+ */
+#include "BatchRunner.h"
+#include "EqualityChecker.h"
+#include "Parser.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace {
+
+// 每个工作线程独占的解析缓冲，clear() 保留容量，预热后不再分配
+struct Workspace
+{
+    AstArena left;
+    AstArena right;
+};
+
+bool isBlank(const std::string &text)
+{
+    return text.find_first_not_of(" \t\r") == std::string::npos;
+}
+
+// 缓存的键：词法分析本来就忽略首尾空白
+std::string_view trimmed(const std::string &text)
+{
+    size_t first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos)
+        return {};
+    size_t last = text.find_last_not_of(" \t\r");
+    return std::string_view(text).substr(first, last - first + 1);
+}
+
+NodeId parseInto(AstArena &arena, const std::string &text)
+{
+    arena.clear();
+    Lexer lexer(text);
+    Parser parser(lexer);
+    return parser.parse(arena);
+}
+
+} // namespace
+
+BatchRunner::BatchRunner(Mode mode, RandomEvaluator evaluator) : mode(mode), evaluator(evaluator) {}
+
+std::vector<ExpressionPair> BatchRunner::readPairs(std::istream &in)
+{
+    std::vector<ExpressionPair> pairs;
+    std::string line;
+    size_t lineNo = 0;
+    while (std::getline(in, line))
+    {
+        ++lineNo;
+        if (isBlank(line))
+            continue;
+        size_t comma = line.find(',');
+        if (comma == std::string::npos)
+            pairs.push_back({lineNo, line, ""});
+        else
+            pairs.push_back({lineNo, line.substr(0, comma), line.substr(comma + 1)});
+    }
+    return pairs;
+}
+
+// 一边的规范形式：命中缓存时直接取出，否则解析、标准化后加入缓存
+static std::string_view canonicalForm(CanonCache &cache, const std::string &text, AstArena &arena,
+                                      std::string &computed)
+{
+    std::string_view key = trimmed(text);
+    std::string_view canonical;
+    if (cache.lookup(key, canonical))
+        return canonical;
+    NodeId root = parseInto(arena, text);
+    computed = EqualityChecker::getStandardizedString(arena, root);
+    cache.insert(key, computed);
+    return computed;
+}
+
+static PairResult evaluatePair(const ExpressionPair &pair, BatchRunner::Mode mode, const RandomEvaluator &evaluator,
+                               CanonCache *cache, Workspace &ws)
+{
+    PairResult result;
+    if (isBlank(pair.right))
+    {
+        result.error = "Expected 'expr1, expr2'";
+        return result;
+    }
+    try
+    {
+        if (cache)
+        {
+            // 规范形式的文本唯一，相等当且仅当标准化后的多项式相等；概率模式只用缓存中已有的结果
+            std::string_view left, right;
+            std::string leftText, rightText;
+            bool known;
+            if (mode == BatchRunner::Mode::Exact)
+            {
+                left = canonicalForm(*cache, pair.left, ws.left, leftText);
+                right = canonicalForm(*cache, pair.right, ws.right, rightText);
+                known = true;
+            }
+            else
+                known = cache->lookup(trimmed(pair.left), left) && cache->lookup(trimmed(pair.right), right);
+            if (known)
+            {
+                result.verdict = left == right ? EqualityVerdict::Equal : EqualityVerdict::Different;
+                result.ok = true;
+                return result;
+            }
+        }
+        NodeId left = parseInto(ws.left, pair.left);
+        NodeId right = parseInto(ws.right, pair.right);
+        if (mode == BatchRunner::Mode::Probabilistic)
+        {
+            result.verdict = evaluator.compare(ws.left, left, ws.right, right);
+        }
+        else
+        {
+            PolyArena arena; // 两个多项式用完即一起释放
+            bool equal = EqualityChecker::standardize(ws.left, left) == EqualityChecker::standardize(ws.right, right);
+            result.verdict = equal ? EqualityVerdict::Equal : EqualityVerdict::Different;
+        }
+        result.ok = true;
+    }
+    catch (const std::exception &err)
+    {
+        result.error = err.what();
+    }
+    return result;
+}
+
+static PairResult comparePair(const ExpressionPair &pair, BatchRunner::Mode mode, const RandomEvaluator &evaluator,
+                              CanonCache *cache, Workspace &ws)
+{
+    if (!PerfStats::enabled())
+        return evaluatePair(pair, mode, evaluator, cache, ws);
+    PerfStats::Request request;
+    PairResult result = evaluatePair(pair, mode, evaluator, cache, ws);
+    result.stats = request.finish();
+    return result;
+}
+
+PairResult BatchRunner::compare(const ExpressionPair &pair) const
+{
+    Workspace ws;
+    return comparePair(pair, mode, evaluator, cache, ws);
+}
+
+std::vector<PairResult> BatchRunner::run(const std::vector<ExpressionPair> &pairs, unsigned threads) const
+{
+    std::vector<PairResult> results(pairs.size());
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    if (threads > pairs.size())
+        threads = static_cast<unsigned>(std::max<size_t>(1, pairs.size()));
+
+    // 每个线程从共享计数器领取下一个下标，结果写入各自的位置，无需加锁
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        Workspace ws;
+        for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < pairs.size();
+             i = next.fetch_add(1, std::memory_order_relaxed))
+        {
+            results[i] = comparePair(pairs[i], mode, evaluator, cache, ws);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t)
+        pool.emplace_back(worker);
+    worker(); // 当前线程也参与
+    for (auto &thread : pool)
+        thread.join();
+    return results;
+}
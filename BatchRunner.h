@@ -0,0 +1,73 @@
+/**
+ * @file BatchRunner.h
+ * @brief Declares the non-interactive batch comparison of expression pairs.
+ *
+ * A batch file holds one "expr1, expr2" pair per line, as in test.txt. BatchRunner spreads
+ * the pairs over a pool of worker threads that claim the next unprocessed index from a
+ * shared atomic counter, and stores each result at its input index, so the output order
+ * is the input order regardless of which thread finished first.
+ *
+ * Workers share no mutable state except the counter and the internally synchronized
+ * SymbolTable: every worker owns its arenas, and Lexer, Parser and EqualityChecker keep
+ * no global state (the keyword table is constexpr, expansion limits are atomics, and
+ * areEqual does not log).
+ *
+ * With a CanonCache attached, a pair whose two sides are both cached is decided by comparing
+ * the cached canonical forms, without parsing. In Exact mode the sides that miss are
+ * standardized as usual and their canonical forms added to the cache.
+ */
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include "CanonCache.h"
+#include "PerfStats.h"
+#include "RandomEvaluator.h"
+#include <istream>
+#include <string>
+#include <vector>
+
+struct ExpressionPair
+{
+    size_t line; // 在输入文件中的行号（从 1 开始）
+    std::string left;
+    std::string right;
+};
+
+struct PairResult
+{
+    bool ok = false;      // 为 false 时 error 中是词法/语法错误信息
+    EqualityVerdict verdict = EqualityVerdict::Different;
+    std::string error;
+    PerfCounters stats; // 本次比较的计数，只在 PerfStats 开启时填写
+};
+
+class BatchRunner
+{
+public:
+    enum class Mode
+    {
+        Exact,        // 完全展开后比较
+        Probabilistic // 只做随机取值判等
+    };
+
+    explicit BatchRunner(Mode mode = Mode::Exact, RandomEvaluator evaluator = RandomEvaluator());
+
+    // 使用持久缓存（由调用方持有，为空时不使用）；键为去掉首尾空白的表达式文本
+    void setCache(CanonCache *canonCache) { cache = canonCache; }
+
+    // 读取 "expr1, expr2" 格式的行，忽略空行；没有逗号的行作为整行报错
+    static std::vector<ExpressionPair> readPairs(std::istream &in);
+
+    // threads 为 0 时使用硬件线程数；结果与 pairs 一一对应
+    std::vector<PairResult> run(const std::vector<ExpressionPair> &pairs, unsigned threads) const;
+
+    // 单线程比较一对表达式
+    PairResult compare(const ExpressionPair &pair) const;
+
+private:
+    Mode mode;
+    RandomEvaluator evaluator;
+    CanonCache *cache = nullptr;
+};
+
+#endif // BATCHRUNNER_H
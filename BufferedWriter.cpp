@@ -0,0 +1,88 @@
+/**
+ * @file BufferedWriter.cpp
+ * @brief Implements the fixed-buffer output stream.
+ */
+#include "BufferedWriter.h"
+#include <cstring>
+#include <stdexcept>
+
+BufferedWriter::BufferedWriter(std::FILE *file, size_t capacity) : file(file), buffer(capacity)
+{
+    if (capacity == 0)
+        throw std::runtime_error("Buffer capacity must be positive");
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+BufferedWriter::~BufferedWriter()
+{
+    try
+    {
+        flush();
+    }
+    catch (const std::exception &)
+    {
+        // 析构时无法再报告写入失败
+    }
+}
+
+// 把 [pbase, pptr) 交给 fwrite 并清空缓冲区
+void BufferedWriter::drain()
+{
+    size_t used = static_cast<size_t>(pptr() - pbase());
+    if (used > 0 && std::fwrite(pbase(), 1, used, file) != used)
+        throw std::runtime_error("Failed to write output");
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+void BufferedWriter::write(std::string_view text)
+{
+    xsputn(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
+void BufferedWriter::put(char c)
+{
+    if (pptr() == epptr())
+        drain();
+    *pptr() = c;
+    pbump(1);
+}
+
+void BufferedWriter::flush()
+{
+    drain();
+    std::fflush(file);
+}
+
+BufferedWriter::int_type BufferedWriter::overflow(int_type ch)
+{
+    drain();
+    if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        put(traits_type::to_char_type(ch));
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize BufferedWriter::xsputn(const char *s, std::streamsize n)
+{
+    size_t count = static_cast<size_t>(n);
+    size_t room = static_cast<size_t>(epptr() - pptr());
+    if (count > room)
+    {
+        drain();
+        // 比整个缓冲区还大的块直接写出，不再拷贝
+        if (count >= buffer.size())
+        {
+            if (std::fwrite(s, 1, count, file) != count)
+                throw std::runtime_error("Failed to write output");
+            return n;
+        }
+    }
+    std::memcpy(pptr(), s, count);
+    pbump(static_cast<int>(count));
+    return n;
+}
+
+int BufferedWriter::sync()
+{
+    flush();
+    return 0;
+}
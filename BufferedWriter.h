@@ -0,0 +1,47 @@
+/**
+ * @file BufferedWriter.h
+ * @brief Declares a large fixed-buffer output stream for the non-interactive CLI modes.
+ *
+ * std::endl flushes on every line, and std::cout synchronized with stdio does little
+ * buffering of its own, so printing one short line per expression turns into one write()
+ * per line. BufferedWriter is a streambuf over a FILE* with a large buffer that is handed to
+ * fwrite only when full, on flush(), or on destruction; it can be wrapped in a std::ostream
+ * so existing operator<< code (e.g. ASTNode::print) writes into it unchanged.
+ */
+#ifndef BUFFEREDWRITER_H
+#define BUFFEREDWRITER_H
+
+#include <cstdio>
+#include <streambuf>
+#include <string_view>
+#include <vector>
+
+class BufferedWriter : public std::streambuf
+{
+public:
+    static constexpr size_t kDefaultCapacity = 1 << 20;
+
+    explicit BufferedWriter(std::FILE *file, size_t capacity = kDefaultCapacity);
+    ~BufferedWriter() override;
+
+    BufferedWriter(const BufferedWriter &) = delete;
+    BufferedWriter &operator=(const BufferedWriter &) = delete;
+
+    void write(std::string_view text);
+    void put(char c);
+    // 把缓冲区写入文件并 fflush
+    void flush();
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char *s, std::streamsize n) override;
+    int sync() override;
+
+private:
+    std::FILE *file;
+    std::vector<char> buffer;
+
+    void drain();
+};
+
+#endif // BUFFEREDWRITER_H
@@ -0,0 +1,282 @@
+/**
+ * @file Bytecode.cpp
+ * @brief Implements lowering of ASTs to postfix bytecode and the interpreter loop.
+ */
+#include "Bytecode.h"
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace
+{
+
+OpCode binaryOpCode(TokenType op)
+{
+    switch (op)
+    {
+    case TokenType::PLUS:
+        return OpCode::Add;
+    case TokenType::MINUS:
+        return OpCode::Sub;
+    case TokenType::MUL:
+        return OpCode::Mul;
+    case TokenType::DIV:
+        return OpCode::Div;
+    case TokenType::POW:
+        return OpCode::Pow;
+    default:
+        throw std::runtime_error("Unsupported binary operator");
+    }
+}
+
+OpCode functionOpCode(TokenType funcType)
+{
+    switch (funcType)
+    {
+    case TokenType::SIN:
+        return OpCode::Sin;
+    case TokenType::COS:
+        return OpCode::Cos;
+    case TokenType::TAN:
+        return OpCode::Tan;
+    case TokenType::COT:
+        return OpCode::Cot;
+    case TokenType::LN:
+        return OpCode::Ln;
+    case TokenType::SQRT:
+        return OpCode::Sqrt;
+    default:
+        throw std::runtime_error("Unsupported function");
+    }
+}
+
+constexpr double kMaxPowInt = 64;
+
+// 按后序发射指令，同时记录栈深度；相同的常数和变量只占一个位置
+struct Emitter
+{
+    // BytecodeProgram 的各部分（由友元 BytecodeCompiler 传入）
+    std::vector<Instruction> &instructions;
+    std::vector<double> &constants;
+    std::vector<std::string> &names;
+    size_t &maxDepth;
+    std::unordered_map<std::string, std::uint32_t> constantIndex{};
+    std::unordered_map<std::string, std::uint32_t> slotIndex{};
+    size_t depth = 0;
+
+    Emitter(std::vector<Instruction> &instructions, std::vector<double> &constants, std::vector<std::string> &names,
+            size_t &maxDepth)
+        : instructions(instructions), constants(constants), names(names), maxDepth(maxDepth)
+    {
+    }
+
+    void emit(OpCode op, std::uint32_t operand, int stackEffect)
+    {
+        instructions.push_back({op, operand});
+        depth += stackEffect;
+        if (depth > maxDepth)
+            maxDepth = depth;
+    }
+
+    void number(std::string_view text)
+    {
+        auto it = constantIndex.find(std::string(text));
+        if (it == constantIndex.end())
+        {
+            // 超出 double 精度的长整数按最接近的 double 取值
+            std::uint32_t index = static_cast<std::uint32_t>(constants.size());
+            constants.push_back(std::strtod(std::string(text).c_str(), nullptr));
+            it = constantIndex.emplace(std::string(text), index).first;
+        }
+        emit(OpCode::Const, it->second, 1);
+    }
+
+    void variable(std::string_view name)
+    {
+        auto it = slotIndex.find(std::string(name));
+        if (it == slotIndex.end())
+        {
+            std::uint32_t index = static_cast<std::uint32_t>(names.size());
+            names.emplace_back(name);
+            it = slotIndex.emplace(std::string(name), index).first;
+        }
+        emit(OpCode::Load, it->second, 1);
+    }
+
+    void unary(TokenType op)
+    {
+        if (op == TokenType::MINUS)
+            emit(OpCode::Neg, 0, 0);
+    }
+
+    void binary(TokenType op)
+    {
+        // 右操作数是刚压入的小整数常数时，把 Const + Pow 合并为 PowInt
+        if (op == TokenType::POW && !instructions.empty() && instructions.back().op == OpCode::Const)
+        {
+            double exponent = constants[instructions.back().operand];
+            if (exponent >= 0 && exponent <= kMaxPowInt && exponent == std::floor(exponent))
+            {
+                instructions.back() = {OpCode::PowInt, static_cast<std::uint32_t>(exponent)};
+                --depth; // 常数不再入栈
+                return;
+            }
+        }
+        emit(binaryOpCode(op), 0, -1);
+    }
+    void function(TokenType funcType) { emit(functionOpCode(funcType), 0, 0); }
+};
+
+// 指令按后序发射；遍历用 walkPostOrder，深层树不占用调用栈
+struct TreeLowering
+{
+    Emitter &out;
+
+    void run(const ASTNode &root) const
+    {
+        walkPostOrder(root, [](const ASTNode &) { return true; }, [&](const ASTNode &node) { visitNode(node, *this); });
+    }
+
+    void operator()(const NumberNode &n) const { out.number(n.value); }
+    void operator()(const VariableNode &v) const { out.variable(v.name); }
+    void operator()(const UnaryOpNode &u) const { out.unary(u.op); }
+    void operator()(const BinaryOpNode &b) const { out.binary(b.op); }
+    void operator()(const FunctionNode &f) const { out.function(f.funcType); }
+};
+
+void lowerArena(Emitter &out, const AstArena &arena, NodeId root)
+{
+    walkPostOrder(arena, root, [](NodeId) { return true; }, [&](NodeId id) {
+        const FlatNode &node = arena[id];
+        switch (node.kind)
+        {
+        case NodeKind::Number:
+            out.number(arena.text(id));
+            return;
+        case NodeKind::Variable:
+            out.variable(arena.text(id));
+            return;
+        case NodeKind::UnaryOp:
+            out.unary(node.op);
+            return;
+        case NodeKind::BinaryOp:
+            out.binary(node.op);
+            return;
+        case NodeKind::Function:
+            out.function(node.op);
+            return;
+        }
+    });
+}
+
+} // namespace
+
+int BytecodeProgram::slot(std::string_view name) const
+{
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        if (names[i] == name)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+double BytecodeProgram::evaluate(const double *slots, double *stack) const
+{
+    // sp 指向下一个空位；指令已按后序排列，保证不会越界
+    double *sp = stack;
+    const double *pool = constants.data();
+    for (const Instruction &ins : instructions)
+    {
+        switch (ins.op)
+        {
+        case OpCode::Const:
+            *sp++ = pool[ins.operand];
+            break;
+        case OpCode::Load:
+            *sp++ = slots[ins.operand];
+            break;
+        case OpCode::Add:
+            --sp;
+            sp[-1] += sp[0];
+            break;
+        case OpCode::Sub:
+            --sp;
+            sp[-1] -= sp[0];
+            break;
+        case OpCode::Mul:
+            --sp;
+            sp[-1] *= sp[0];
+            break;
+        case OpCode::Div:
+            --sp;
+            sp[-1] /= sp[0];
+            break;
+        case OpCode::Pow:
+            --sp;
+            sp[-1] = std::pow(sp[-1], sp[0]);
+            break;
+        case OpCode::PowInt:
+        {
+            double base = sp[-1], result = 1;
+            for (std::uint32_t e = ins.operand; e > 0; e >>= 1)
+            {
+                if (e & 1)
+                    result *= base;
+                base *= base;
+            }
+            sp[-1] = result;
+            break;
+        }
+        case OpCode::Neg:
+            sp[-1] = -sp[-1];
+            break;
+        case OpCode::Sin:
+            sp[-1] = std::sin(sp[-1]);
+            break;
+        case OpCode::Cos:
+            sp[-1] = std::cos(sp[-1]);
+            break;
+        case OpCode::Tan:
+            sp[-1] = std::tan(sp[-1]);
+            break;
+        case OpCode::Cot:
+            sp[-1] = 1.0 / std::tan(sp[-1]);
+            break;
+        case OpCode::Ln:
+            sp[-1] = std::log(sp[-1]);
+            break;
+        case OpCode::Sqrt:
+            sp[-1] = std::sqrt(sp[-1]);
+            break;
+        }
+    }
+    return sp == stack ? 0.0 : sp[-1];
+}
+
+double BytecodeProgram::evaluate(const std::vector<double> &slots) const
+{
+    if (slots.size() < names.size())
+        throw std::runtime_error("Missing variable values");
+    std::vector<double> stack(maxDepth);
+    return evaluate(slots.data(), stack.data());
+}
+
+BytecodeProgram BytecodeCompiler::compile(const ASTNode &root)
+{
+    BytecodeProgram program;
+    Emitter out(program.instructions, program.constants, program.names, program.maxDepth);
+    TreeLowering{out}.run(root);
+    return program;
+}
+
+BytecodeProgram BytecodeCompiler::compile(const AstArena &arena, NodeId root)
+{
+    BytecodeProgram program;
+    if (root == kNullNode)
+        return program;
+    Emitter out(program.instructions, program.constants, program.names, program.maxDepth);
+    lowerArena(out, arena, root);
+    return program;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file Bytecode.h
+ * @brief Declares the bytecode compiler and stack VM for numeric evaluation of expressions.
+ *
+ * BytecodeCompiler lowers a parsed expression (shared_ptr tree or AstArena) into a flat
+ * postfix instruction array. Numbers become entries of a constant pool and variables become
+ * numbered slots, so evaluating the program at a new binding is a single loop over a
+ * contiguous array with a small value stack: no pointer chasing, no virtual calls and no
+ * name lookups. Compile once, then call evaluate() for as many bindings as needed.
+ *
+ * evaluateBatch() runs the same program over many bindings at once (see BytecodeBatch.cpp):
+ * inputs are one array per variable slot, and every instruction is applied to a block of
+ * points with vectorizable kernels (AVX2 when the CPU has it, a generic build otherwise).
+ * sin/cos/tan/cot/ln use polynomial approximations in the batch path:
+ *   - sin, cos: absolute error below 1e-14 for |x| <= 1e6 (larger |x| use std::sin/std::cos);
+ *   - tan, cot: the quotient of those approximations, relative error below 1e-14 except
+ *     within about 1e-14 / |denominator| of a pole;
+ *   - ln: relative error below 1e-15 for normal positive inputs (others use std::log).
+ * Arithmetic, integer powers and sqrt give the same results as evaluate().
+ */
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include "AST.h"
+#include "AstArena.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class OpCode : std::uint8_t
+{
+    Const, // 压入 constants[operand]
+    Load,  // 压入 slots[operand]
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Pow,
+    PowInt, // 指数为整数常数 operand 时，用乘法代替 std::pow
+    Neg,
+    Sin,
+    Cos,
+    Tan,
+    Cot,
+    Ln,
+    Sqrt
+};
+
+struct Instruction
+{
+    OpCode op;
+    std::uint32_t operand; // Const / Load 的下标，PowInt 的指数，其余指令不使用
+};
+
+class BytecodeProgram
+{
+public:
+    // 变量槽位：slotNames()[i] 的值放在 evaluate 参数的第 i 个位置
+    const std::vector<std::string> &slotNames() const { return names; }
+    // 变量名对应的槽位，不存在时返回 -1
+    int slot(std::string_view name) const;
+
+    const std::vector<Instruction> &code() const { return instructions; }
+    size_t maxStackDepth() const { return maxDepth; }
+
+    // slots 至少包含 slotNames().size() 个值；stack 至少包含 maxStackDepth() 个位置
+    double evaluate(const double *slots, double *stack) const;
+    double evaluate(const std::vector<double> &slots) const;
+
+    // 批量求值：columns[i] 指向槽位 i 的 count 个取值（每个变量一个数组），结果写入 out[0, count)
+    void evaluateBatch(const double *const *columns, size_t count, double *out) const;
+
+private:
+    friend class BytecodeCompiler;
+
+    std::vector<Instruction> instructions;
+    std::vector<double> constants;
+    std::vector<std::string> names;
+    size_t maxDepth = 0;
+};
+
+class BytecodeCompiler
+{
+public:
+    static BytecodeProgram compile(const ASTNode &root);
+    static BytecodeProgram compile(const AstArena &arena, NodeId root);
+};
+
+#endif // BYTECODE_H
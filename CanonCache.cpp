@@ -0,0 +1,263 @@
+/**
+ * @file CanonCache.cpp
+ * @brief Implements the memory-mapped canonical form cache (POSIX mmap).
+ */
+#include "CanonCache.h"
+#include "AST.h"
+#include "EqualityChecker.h"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+constexpr char kMagic[8] = {'S', 'M', 'A', 'C', 'A', 'N', 'O', 'N'};
+// 文件格式的版本，与标准化规则无关；字节序不同的机器上读出的值也不同，文件会被忽略
+constexpr std::uint32_t kFormatVersion = 1;
+
+// 0 表示空槽，真实的哈希值避开 0
+std::uint64_t keyHash(std::string_view expr)
+{
+    std::uint64_t h = hashText(expr);
+    return h == 0 ? 1 : h;
+}
+
+} // namespace
+
+struct CanonCache::Header
+{
+    char magic[8];
+    std::uint32_t formatVersion;
+    std::uint32_t slotSize; // sizeof(Slot)，防止读到布局不同的文件
+    std::uint64_t rules;    // EqualityChecker::rulesFingerprint()
+    std::uint64_t slotCount;
+    std::uint64_t entryCount;
+    std::uint64_t poolSize;
+};
+
+// 文本与规范形式在字符池中相邻存放：[offset, offset + textLength) 是文本，紧接着是规范形式
+struct CanonCache::Slot
+{
+    std::uint64_t hash;
+    std::uint64_t offset;
+    std::uint32_t textLength;
+    std::uint32_t canonLength;
+};
+
+CanonCache::CanonCache(std::string path) : path(std::move(path)), rules(EqualityChecker::rulesFingerprint())
+{
+    map();
+}
+
+CanonCache::~CanonCache()
+{
+    unmap();
+}
+
+const CanonCache::Header &CanonCache::header() const
+{
+    return *reinterpret_cast<const Header *>(base);
+}
+
+const CanonCache::Slot *CanonCache::slots() const
+{
+    return reinterpret_cast<const Slot *>(base + sizeof(Header));
+}
+
+const char *CanonCache::pool() const
+{
+    return base + sizeof(Header) + header().slotCount * sizeof(Slot);
+}
+
+void CanonCache::map()
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header))
+    {
+        ::close(fd);
+        return;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void *addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // 映射在关闭文件后仍然有效
+    if (addr == MAP_FAILED)
+        return;
+    base = static_cast<const char *>(addr);
+    mappedSize = size;
+
+    // 只检查头部和总大小，条目在查找时再做边界检查
+    const Header &h = header();
+    bool valid = std::memcmp(h.magic, kMagic, sizeof(kMagic)) == 0 && h.formatVersion == kFormatVersion &&
+                 h.slotSize == sizeof(Slot) && h.rules == rules && h.slotCount > 0 &&
+                 (h.slotCount & (h.slotCount - 1)) == 0 &&
+                 h.slotCount <= (size - sizeof(Header)) / sizeof(Slot) &&
+                 h.poolSize == size - sizeof(Header) - h.slotCount * sizeof(Slot);
+    if (!valid)
+        unmap();
+}
+
+void CanonCache::unmap()
+{
+    if (base)
+        ::munmap(const_cast<char *>(base), mappedSize);
+    base = nullptr;
+    mappedSize = 0;
+}
+
+bool CanonCache::findMapped(std::string_view expr, std::uint64_t hash, std::string_view &canonical) const
+{
+    if (!base)
+        return false;
+    const Header &h = header();
+    const Slot *table = slots();
+    const char *chars = pool();
+    std::uint64_t mask = h.slotCount - 1;
+    // 装载率不超过一半，线性探测到空槽即可判定不存在；最多探测 slotCount 次，防止损坏的文件造成死循环
+    for (std::uint64_t i = 0, pos = hash & mask; i <= mask; ++i, pos = (pos + 1) & mask)
+    {
+        const Slot &slot = table[pos];
+        if (slot.hash == 0)
+            return false;
+        if (slot.hash != hash || slot.textLength != expr.size())
+            continue;
+        std::uint64_t length = std::uint64_t(slot.textLength) + slot.canonLength;
+        if (slot.offset > h.poolSize || length > h.poolSize - slot.offset)
+            return false; // 损坏的条目
+        if (std::memcmp(chars + slot.offset, expr.data(), expr.size()) == 0)
+        {
+            canonical = std::string_view(chars + slot.offset + slot.textLength, slot.canonLength);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CanonCache::lookup(std::string_view expr, std::string_view &canonical) const
+{
+    if (findMapped(expr, keyHash(expr), canonical))
+    {
+        hitCount.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        // 文本在 pendingText 中，地址不变，返回的 string_view 在缓存存在期间有效
+        auto it = pending.find(expr);
+        if (it != pending.end())
+        {
+            canonical = it->second;
+            hitCount.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    missCount.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void CanonCache::insert(std::string_view expr, std::string_view canonical)
+{
+    std::string_view existing;
+    if (findMapped(expr, keyHash(expr), existing))
+        return;
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (pending.count(expr))
+        return;
+    std::string_view key = pendingText.emplace_back(expr);
+    pending.emplace(key, pendingText.emplace_back(canonical));
+}
+
+size_t CanonCache::mappedEntries() const
+{
+    return base ? static_cast<size_t>(header().entryCount) : 0;
+}
+
+size_t CanonCache::pendingEntries() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return pending.size();
+}
+
+void CanonCache::save()
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (pending.size() == savedPending)
+        return;
+
+    // 收集映射中的有效条目与新条目；pending 中的键在插入时已确认不在映射中
+    struct Entry
+    {
+        std::uint64_t hash;
+        std::string_view text;
+        std::string_view canonical;
+    };
+    std::vector<Entry> entries;
+    entries.reserve(mappedEntries() + pending.size());
+    if (base)
+    {
+        const Header &h = header();
+        for (std::uint64_t i = 0; i < h.slotCount; ++i)
+        {
+            const Slot &slot = slots()[i];
+            std::uint64_t length = std::uint64_t(slot.textLength) + slot.canonLength;
+            if (slot.hash == 0 || slot.offset > h.poolSize || length > h.poolSize - slot.offset)
+                continue;
+            const char *text = pool() + slot.offset;
+            entries.push_back({slot.hash, std::string_view(text, slot.textLength),
+                               std::string_view(text + slot.textLength, slot.canonLength)});
+        }
+    }
+    for (const auto &entry : pending)
+        entries.push_back({keyHash(entry.first), entry.first, entry.second});
+
+    Header h{};
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.formatVersion = kFormatVersion;
+    h.slotSize = sizeof(Slot);
+    h.rules = rules;
+    h.slotCount = 16;
+    while (h.slotCount < entries.size() * 2)
+        h.slotCount *= 2;
+
+    std::vector<Slot> table(h.slotCount, Slot{0, 0, 0, 0});
+    std::string chars;
+    for (const Entry &entry : entries)
+    {
+        if (entry.text.size() > UINT32_MAX || entry.canonical.size() > UINT32_MAX)
+            continue;
+        std::uint64_t pos = entry.hash & (h.slotCount - 1);
+        while (table[pos].hash != 0)
+            pos = (pos + 1) & (h.slotCount - 1);
+        table[pos] = {entry.hash, chars.size(), static_cast<std::uint32_t>(entry.text.size()),
+                      static_cast<std::uint32_t>(entry.canonical.size())};
+        chars.append(entry.text);
+        chars.append(entry.canonical);
+        ++h.entryCount;
+    }
+    h.poolSize = chars.size();
+
+    // 先写临时文件再 rename，读者只会看到完整的旧文件或新文件
+    std::string temp = path + ".tmp." + std::to_string(::getpid());
+    std::FILE *file = std::fopen(temp.c_str(), "wb");
+    if (!file)
+        throw std::runtime_error("Cannot write cache file " + temp);
+    bool ok = std::fwrite(&h, sizeof(h), 1, file) == 1 &&
+              std::fwrite(table.data(), sizeof(Slot), table.size(), file) == table.size() &&
+              std::fwrite(chars.data(), 1, chars.size(), file) == chars.size();
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(temp.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temp.c_str());
+        throw std::runtime_error("Cannot write cache file " + path);
+    }
+    // 已返回的 string_view 仍指向旧映射和 pending，因此两者都保留到析构，不重新映射新文件
+    savedPending = pending.size();
+}
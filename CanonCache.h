@@ -0,0 +1,90 @@
+/**
+ * @file CanonCache.h
+ * @brief Declares a persistent, memory-mapped cache from expression text to canonical form.
+ *
+ * Grading runs see the same expression strings night after night. CanonCache stores the
+ * canonical form (EqualityChecker::getStandardizedString) of every expression it has seen
+ * in a single file that is mapped read-only and used in place: opening it reads only the
+ * fixed-size header, and a lookup hashes the text, probes an open-addressing slot table and
+ * compares the stored text, touching a few pages at most.
+ *
+ * File layout (native byte order, all offsets in bytes):
+ *   Header                  magic, format version, rules fingerprint, slot/entry/pool sizes
+ *   Slot[slotCount]         hash of the text (0 = empty), text and canonical form as
+ *                           (offset, length) pairs into the pool; slotCount is a power of two
+ *   char pool[poolSize]     the texts and canonical forms, back to back
+ *
+ * The header records EqualityChecker::rulesFingerprint(); a file written under different
+ * rules (new version, different expansion limits, or any change in the probe outputs) is
+ * ignored and replaced on the next save(). New results are kept in memory and written by
+ * save(), which merges them with the mapped entries into a temporary file and renames it
+ * over the old one. Any number of processes can read the file meanwhile: a mapping stays
+ * valid after the rename, and readers that open later see either the old or the new file,
+ * never a partial one. Concurrent writers do not corrupt the file, but the last rename
+ * wins, so entries added only by the other writer are dropped until seen again.
+ *
+ * lookup() and insert() are safe to call from several threads.
+ */
+#ifndef CANONCACHE_H
+#define CANONCACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+class CanonCache
+{
+public:
+    // 打开 path；文件不存在、格式不对或规则指纹不同时视为空缓存（不报错）
+    explicit CanonCache(std::string path);
+    ~CanonCache();
+
+    CanonCache(const CanonCache &) = delete;
+    CanonCache &operator=(const CanonCache &) = delete;
+
+    // 命中时 canonical 指向缓存中的规范形式，在 CanonCache 析构前有效
+    bool lookup(std::string_view expr, std::string_view &canonical) const;
+    // 记下新的结果，save() 时写入文件；已有的键不会被覆盖
+    void insert(std::string_view expr, std::string_view canonical);
+    // 有新条目时合并写回；写入失败抛出 std::runtime_error。
+    // 之后的查找仍使用打开时的映射和内存中的条目
+    void save();
+
+    // 打开时有效的条目数（不含本次新增的）
+    size_t mappedEntries() const;
+    size_t pendingEntries() const;
+    size_t hits() const { return hitCount.load(std::memory_order_relaxed); }
+    size_t misses() const { return missCount.load(std::memory_order_relaxed); }
+
+private:
+    struct Header;
+    struct Slot;
+
+    std::string path;
+    std::uint64_t rules;
+    const char *base = nullptr; // 映射的起始地址，没有有效文件时为空
+    size_t mappedSize = 0;
+
+    mutable std::shared_mutex mutex; // 保护 pending 与 pendingText
+    // 新条目：键和值都指向 pendingText 中的文本，查找时直接用 string_view，不构造 std::string
+    std::unordered_map<std::string_view, std::string_view> pending;
+    std::deque<std::string> pendingText; // 追加时已有元素的地址不变
+    size_t savedPending = 0; // 上次 save() 时 pending 的大小
+
+    mutable std::atomic<size_t> hitCount{0};
+    mutable std::atomic<size_t> missCount{0};
+
+    void map();
+    void unmap();
+    const Header &header() const;
+    const Slot *slots() const;
+    const char *pool() const;
+    bool findMapped(std::string_view expr, std::uint64_t hash, std::string_view &canonical) const;
+};
+
+#endif // CANONCACHE_H
@@ -0,0 +1,414 @@
+/**
+ * @file Coefficient.cpp
+ * @brief Implements the arbitrary-precision slow paths of Coefficient.
+ */
+#include "Coefficient.h"
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+using Mag = std::vector<std::uint32_t>;
+
+void trim(Mag& m) {
+    while (!m.empty() && m.back() == 0) m.pop_back();
+}
+
+Mag fromU64(std::uint64_t v) {
+    Mag m;
+    while (v) {
+        m.push_back(static_cast<std::uint32_t>(v));
+        v >>= 32;
+    }
+    return m;
+}
+
+int compareMag(const Mag& a, const Mag& b) {
+    if (a.size() != b.size()) return a.size() < b.size() ? -1 : 1;
+    for (size_t i = a.size(); i-- > 0;) {
+        if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+Mag addMag(const Mag& a, const Mag& b) {
+    Mag r(std::max(a.size(), b.size()) + 1, 0);
+    std::uint64_t carry = 0;
+    for (size_t i = 0; i < r.size(); ++i) {
+        std::uint64_t sum = carry;
+        if (i < a.size()) sum += a[i];
+        if (i < b.size()) sum += b[i];
+        r[i] = static_cast<std::uint32_t>(sum);
+        carry = sum >> 32;
+    }
+    trim(r);
+    return r;
+}
+
+// 要求 a >= b
+Mag subMag(const Mag& a, const Mag& b) {
+    Mag r(a.size(), 0);
+    std::int64_t borrow = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        std::int64_t diff = static_cast<std::int64_t>(a[i]) - borrow - (i < b.size() ? b[i] : 0);
+        borrow = diff < 0;
+        if (diff < 0) diff += std::int64_t(1) << 32;
+        r[i] = static_cast<std::uint32_t>(diff);
+    }
+    trim(r);
+    return r;
+}
+
+Mag mulMag(const Mag& a, const Mag& b) {
+    if (a.empty() || b.empty()) return {};
+    Mag r(a.size() + b.size(), 0);
+    for (size_t i = 0; i < a.size(); ++i) {
+        std::uint64_t carry = 0;
+        for (size_t j = 0; j < b.size(); ++j) {
+            std::uint64_t cur = r[i + j] + static_cast<std::uint64_t>(a[i]) * b[j] + carry;
+            r[i + j] = static_cast<std::uint32_t>(cur);
+            carry = cur >> 32;
+        }
+        size_t k = i + b.size();
+        while (carry) {
+            std::uint64_t cur = r[k] + carry;
+            r[k++] = static_cast<std::uint32_t>(cur);
+            carry = cur >> 32;
+        }
+    }
+    trim(r);
+    return r;
+}
+
+// m = m * mul + add
+void mulAddSmall(Mag& m, std::uint32_t mul, std::uint32_t add) {
+    std::uint64_t carry = add;
+    for (auto& limb : m) {
+        std::uint64_t cur = static_cast<std::uint64_t>(limb) * mul + carry;
+        limb = static_cast<std::uint32_t>(cur);
+        carry = cur >> 32;
+    }
+    if (carry) m.push_back(static_cast<std::uint32_t>(carry));
+}
+
+// m = m / div，返回余数
+std::uint32_t divSmall(Mag& m, std::uint32_t div) {
+    std::uint64_t rem = 0;
+    for (size_t i = m.size(); i-- > 0;) {
+        std::uint64_t cur = (rem << 32) | m[i];
+        m[i] = static_cast<std::uint32_t>(cur / div);
+        rem = cur % div;
+    }
+    trim(m);
+    return static_cast<std::uint32_t>(rem);
+}
+
+// 2^64 ≡ 59 (mod kHashPrime)：高位乘 59 折叠回低位
+std::uint64_t addHash(std::uint64_t x, std::uint64_t y) {
+    std::uint64_t r = x + y;
+    if (r < x) r += 59; // 溢出了 2^64
+    return r >= Coefficient::kHashPrime ? r - Coefficient::kHashPrime : r;
+}
+
+std::uint64_t subHash(std::uint64_t x, std::uint64_t y) { return x >= y ? x - y : x + (Coefficient::kHashPrime - y); }
+
+// m mod kHashPrime，按 Horner 法从高位算起
+std::uint64_t hashMag(const Mag& m) {
+    std::uint64_t h = 0;
+    for (size_t i = m.size(); i-- > 0;) {
+        // h * 2^32 + limb = (h >> 32) * 2^64 + ((h << 32) | limb)
+        h = addHash((h >> 32) * 59, (h << 32) | m[i]);
+    }
+    return h;
+}
+
+// a += b（各自 count 位），a 按需加长
+void addMagInPlace(Mag& a, const std::uint32_t* b, size_t count) {
+    if (a.size() < count) a.resize(count, 0);
+    std::uint64_t carry = 0;
+    size_t i = 0;
+    for (; i < count || (carry && i < a.size()); ++i) {
+        std::uint64_t sum = static_cast<std::uint64_t>(a[i]) + carry + (i < count ? b[i] : 0);
+        a[i] = static_cast<std::uint32_t>(sum);
+        carry = sum >> 32;
+    }
+    if (carry) a.push_back(static_cast<std::uint32_t>(carry));
+}
+
+// a -= b，要求 a >= b
+void subMagInPlace(Mag& a, const std::uint32_t* b, size_t count) {
+    std::int64_t borrow = 0;
+    for (size_t i = 0; i < count || borrow; ++i) {
+        std::int64_t diff = static_cast<std::int64_t>(a[i]) - borrow - (i < count ? b[i] : 0);
+        borrow = diff < 0;
+        if (diff < 0) diff += std::int64_t(1) << 32;
+        a[i] = static_cast<std::uint32_t>(diff);
+    }
+    trim(a);
+}
+
+} // namespace
+
+Coefficient& Coefficient::operator=(const Coefficient& other) {
+    if (this != &other) {
+        Coefficient copy(other);
+        std::swap(word, copy.word);
+    }
+    return *this;
+}
+
+Coefficient& Coefficient::operator=(Coefficient&& other) noexcept {
+    if (this != &other) {
+        if (!isSmall()) release();
+        word = other.word;
+        other.word = 0;
+    }
+    return *this;
+}
+
+void Coefficient::copyBig(const Coefficient& other) {
+    word = static_cast<std::int64_t>(reinterpret_cast<std::uintptr_t>(new Big(*other.big())) | 1);
+}
+
+void Coefficient::release() {
+    delete big();
+    word = 0;
+}
+
+Coefficient Coefficient::fromString(std::string_view digits) {
+    // 18 位以内一定在内联范围内
+    if (digits.size() <= 18) {
+        std::int64_t v = 0;
+        for (char c : digits) v = v * 10 + (c - '0');
+        return Coefficient(v);
+    }
+    Big value;
+    for (char c : digits) mulAddSmall(value.mag, 10, static_cast<std::uint32_t>(c - '0'));
+    trim(value.mag);
+    Coefficient result;
+    result.assign(std::move(value));
+    return result;
+}
+
+Coefficient::Big Coefficient::toBig() const {
+    if (!isSmall()) return *big();
+    std::int64_t v = smallValue();
+    Big b;
+    b.negative = v < 0;
+    // 先转无符号再取反，避免溢出
+    b.mag = fromU64(v < 0 ? 0 - static_cast<std::uint64_t>(v) : static_cast<std::uint64_t>(v));
+    return b;
+}
+
+void Coefficient::assignLarge(std::int64_t value) {
+    Big b;
+    b.negative = value < 0;
+    b.mag = fromU64(value < 0 ? 0 - static_cast<std::uint64_t>(value) : static_cast<std::uint64_t>(value));
+    assign(std::move(b));
+}
+
+void Coefficient::assign(Big value) {
+    trim(value.mag);
+    if (value.mag.size() <= 2) {
+        std::uint64_t m = 0;
+        if (!value.mag.empty()) m = value.mag[0];
+        if (value.mag.size() == 2) m |= static_cast<std::uint64_t>(value.mag[1]) << 32;
+        std::uint64_t limit = value.negative ? static_cast<std::uint64_t>(kMaxSmall) + 1
+                                             : static_cast<std::uint64_t>(kMaxSmall);
+        if (m <= limit) {
+            if (!isSmall()) release();
+            std::int64_t v = value.negative ? static_cast<std::int64_t>(0 - m) : static_cast<std::int64_t>(m);
+            word = static_cast<std::int64_t>(static_cast<std::uint64_t>(v) << 1);
+            return;
+        }
+    }
+    value.hash = hashMag(value.mag);
+    if (isSmall()) {
+        word = static_cast<std::int64_t>(reinterpret_cast<std::uintptr_t>(new Big(std::move(value))) | 1);
+    } else {
+        *big() = std::move(value);
+    }
+}
+
+bool Coefficient::toInt(int& out) const {
+    if (!isSmall() || smallValue() < INT32_MIN || smallValue() > INT32_MAX) return false;
+    out = static_cast<int>(smallValue());
+    return true;
+}
+
+size_t Coefficient::bitLength() const {
+    if (isSmall()) {
+        std::int64_t v = smallValue();
+        std::uint64_t m = v < 0 ? 0 - static_cast<std::uint64_t>(v) : static_cast<std::uint64_t>(v);
+        return m == 0 ? 0 : 64 - static_cast<size_t>(__builtin_clzll(m));
+    }
+    const Mag& mag = big()->mag;
+    return mag.size() * 32 - static_cast<size_t>(__builtin_clz(mag.back()));
+}
+
+const std::uint32_t* Coefficient::limbs(std::uint32_t (&buf)[2], size_t& count) const {
+    if (!isSmall()) {
+        count = big()->mag.size();
+        return big()->mag.data();
+    }
+    std::int64_t v = smallValue();
+    std::uint64_t m = v < 0 ? 0 - static_cast<std::uint64_t>(v) : static_cast<std::uint64_t>(v);
+    count = 0;
+    for (; m != 0; m >>= 32) buf[count++] = static_cast<std::uint32_t>(m);
+    return buf;
+}
+
+std::uint64_t Coefficient::magnitudeHash() const {
+    if (!isSmall()) return big()->hash;
+    // 内联值的绝对值不超过 2^62 < kHashPrime；-2^62 内联而 2^62 不内联，两者的哈希仍然相同
+    std::int64_t v = smallValue();
+    return v < 0 ? 0 - static_cast<std::uint64_t>(v) : static_cast<std::uint64_t>(v);
+}
+
+int Coefficient::sign() const {
+    if (!isSmall()) return big()->negative ? -1 : 1;
+    return (word > 0) - (word < 0);
+}
+
+int Coefficient::compare(const Coefficient& other) const {
+    int sa = sign(), sb = other.sign();
+    if (sa != sb) return sa < sb ? -1 : 1;
+    Big a = toBig(), b = other.toBig();
+    int c = compareMag(a.mag, b.mag);
+    return sa < 0 ? -c : c;
+}
+
+bool Coefficient::equalSlow(const Coefficient& other) const {
+    // 规范化保证内联范围内的数值总是内联存储
+    if (isSmall() || other.isSmall()) return false;
+    return big()->negative == other.big()->negative && big()->mag == other.big()->mag;
+}
+
+bool Coefficient::addInPlace(const Coefficient& other) {
+    if (isSmall() || this == &other) return false;
+    Big& a = *big();
+    std::uint32_t buf[2];
+    size_t count = 0;
+    const std::uint32_t* b = other.limbs(buf, count);
+    // 内联值的绝对值不超过 2^62，总不大于大数；两个大数才需要比较
+    if (!other.isSmall() && (count > a.mag.size() || (count == a.mag.size() && compareMag(a.mag, other.big()->mag) < 0)))
+        return false;
+    std::uint64_t h = other.magnitudeHash();
+    if ((other.sign() < 0) == a.negative) {
+        addMagInPlace(a.mag, b, count);
+        a.hash = addHash(a.hash, h);
+        return true;
+    }
+    subMagInPlace(a.mag, b, count);
+    a.hash = subHash(a.hash, h);
+    // 相减后可能回到内联范围（或为 0）
+    if (a.mag.size() <= 2) assign(std::move(a));
+    return true;
+}
+
+Coefficient& Coefficient::addSlow(const Coefficient& other) {
+    if (addInPlace(other)) return *this;
+    Big a = toBig(), b = other.toBig();
+    Big r;
+    if (a.negative == b.negative) {
+        r.negative = a.negative;
+        r.mag = addMag(a.mag, b.mag);
+    } else if (compareMag(a.mag, b.mag) >= 0) {
+        r.negative = a.negative;
+        r.mag = subMag(a.mag, b.mag);
+    } else {
+        r.negative = b.negative;
+        r.mag = subMag(b.mag, a.mag);
+    }
+    if (r.mag.empty()) r.negative = false;
+    assign(std::move(r));
+    return *this;
+}
+
+Coefficient& Coefficient::mulSlow(const Coefficient& other) {
+    Big a = toBig(), b = other.toBig();
+    Big r;
+    r.mag = mulMag(a.mag, b.mag);
+    r.negative = !r.mag.empty() && a.negative != b.negative;
+    assign(std::move(r));
+    return *this;
+}
+
+Coefficient Coefficient::sumSlow(const Coefficient& a, const Coefficient& b) {
+    Coefficient result(a);
+    result.addSlow(b);
+    return result;
+}
+
+Coefficient Coefficient::productSlow(const Coefficient& a, const Coefficient& b) {
+    Coefficient result(a);
+    result.mulSlow(b);
+    return result;
+}
+
+void Coefficient::negateSlow() {
+    Big r = toBig();
+    if (!r.mag.empty()) r.negative = !r.negative;
+    assign(std::move(r));
+}
+
+std::string Coefficient::absString() const {
+    if (isSmall()) {
+        std::int64_t v = smallValue();
+        return std::to_string(v < 0 ? 0 - static_cast<std::uint64_t>(v) : static_cast<std::uint64_t>(v));
+    }
+    // 每次除以 10^9 取出 9 位十进制数字
+    Mag m = big()->mag;
+    std::vector<std::uint32_t> chunks;
+    while (!m.empty()) chunks.push_back(divSmall(m, 1000000000u));
+    std::string s = std::to_string(chunks.back());
+    for (size_t i = chunks.size() - 1; i-- > 0;) {
+        std::string part = std::to_string(chunks[i]);
+        s += std::string(9 - part.size(), '0') + part;
+    }
+    return s;
+}
+
+std::string Coefficient::toString() const {
+    return sign() < 0 ? "-" + absString() : absString();
+}
+
+std::uint64_t Coefficient::mod(std::uint64_t p) const {
+    if (isSmall()) {
+        std::int64_t v = smallValue();
+        if (v >= 0 && static_cast<std::uint64_t>(v) < p) return static_cast<std::uint64_t>(v); // 常见情况，免去除法
+        std::int64_t r = v % static_cast<std::int64_t>(p);
+        return static_cast<std::uint64_t>(r < 0 ? r + static_cast<std::int64_t>(p) : r);
+    }
+    const Big& b = *big();
+    unsigned __int128 r = 0;
+    for (size_t i = b.mag.size(); i-- > 0;) {
+        r = ((r << 32) | b.mag[i]) % p;
+    }
+    std::uint64_t result = static_cast<std::uint64_t>(r);
+    return b.negative && result != 0 ? p - result : result;
+}
+
+void Coefficient::encode(std::vector<std::int64_t>& out) const {
+    if (isSmall()) {
+        out.push_back(0);
+        out.push_back(smallValue());
+        return;
+    }
+    const Big& b = *big();
+    out.push_back(1);
+    out.push_back(b.negative);
+    out.push_back(static_cast<std::int64_t>(b.mag.size()));
+    out.insert(out.end(), b.mag.begin(), b.mag.end());
+}
+
+Coefficient Coefficient::decode(const std::vector<std::int64_t>& in, size_t& pos) {
+    if (in[pos++] == 0) return Coefficient(in[pos++]);
+    Big value;
+    value.negative = in[pos++] != 0;
+    size_t count = static_cast<size_t>(in[pos++]);
+    for (size_t i = 0; i < count; ++i) value.mag.push_back(static_cast<std::uint32_t>(in[pos++]));
+    Coefficient result;
+    result.assign(std::move(value));
+    return result;
+}
@@ -0,0 +1,164 @@
+/**
+ * @file Coefficient.h
+ * @brief Declares the overflow-safe integer coefficient used by polynomial terms.
+ *
+ * A Coefficient is one tagged machine word, the same size as the pointer it may hold: an even
+ * word is an inline value shifted left by one bit (63-bit range), an odd word points to an
+ * arbitrary-precision magnitude on the heap. Arithmetic on two inline values works directly
+ * on the shifted words with one overflow-checked builtin and a branch; only a result outside
+ * the inline range spills to the heap. Results that fit again are demoted back to the inline
+ * form, so equal values always have the same representation.
+ *
+ * A heap magnitude also stores its residue modulo a second prime (magnitudeHash), computed
+ * when the magnitude is built. Adding a value no larger than a heap magnitude changes it in
+ * place, touching only the limbs the carry or borrow reaches, and updates the residue in
+ * O(1), so a small change to a huge coefficient does not copy or rescan it.
+ */
+#ifndef COEFFICIENT_H
+#define COEFFICIENT_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Coefficient {
+public:
+    Coefficient(std::int64_t value = 0) {
+        if (value >= kMinSmall && value <= kMaxSmall) {
+            word = static_cast<std::int64_t>(static_cast<std::uint64_t>(value) << 1);
+        } else {
+            word = 0;
+            assignLarge(value);
+        }
+    }
+    Coefficient(const Coefficient& other) : word(other.word) {
+        if (!other.isSmall()) copyBig(other);
+    }
+    Coefficient(Coefficient&& other) noexcept : word(other.word) { other.word = 0; }
+    Coefficient& operator=(const Coefficient& other);
+    Coefficient& operator=(Coefficient&& other) noexcept;
+    ~Coefficient() {
+        if (!isSmall()) release();
+    }
+
+    // 解析十进制数字串（不含符号），任意长度
+    static Coefficient fromString(std::string_view digits);
+
+    bool isZero() const { return word == 0; }
+    // 是否以内联机器字存储
+    bool isSmall() const { return (word & 1) == 0; }
+    // 若数值能放入 int，写入 out 并返回 true
+    bool toInt(int& out) const;
+    int sign() const;
+    // 绝对值是否为 1
+    bool isUnit() const { return word == 2 || word == -2; }
+    // 绝对值的二进制位数，0 的位数为 0
+    size_t bitLength() const;
+    // 绝对值是否小于 2^60（内联值以 2v 存储，即 |word| < 2^61）
+    bool isNarrow() const { return isSmall() && word > -(std::int64_t(1) << 61) && word < (std::int64_t(1) << 61); }
+    // 绝对值的哈希：|value| mod kHashPrime，只取决于数值，与符号无关；O(1)
+    std::uint64_t magnitudeHash() const;
+
+    // 2^64 - 59，小于它的内联绝对值就是自身的哈希
+    static constexpr std::uint64_t kHashPrime = 0xffffffffffffffc5ULL;
+
+    // 内联值以 2v 存储：(2a)+(2b) = 2(a+b)，(2a)*b = 2(ab)，溢出检查直接作用于存储字
+    Coefficient& operator+=(const Coefficient& other) {
+        std::int64_t r;
+        if (isSmall() && other.isSmall() && !__builtin_add_overflow(word, other.word, &r)) {
+            word = r;
+            return *this;
+        }
+        return addSlow(other);
+    }
+    Coefficient& operator*=(const Coefficient& other) {
+        std::int64_t r;
+        if (isSmall() && other.isSmall() && !__builtin_mul_overflow(word, other.word >> 1, &r)) {
+            word = r;
+            return *this;
+        }
+        return mulSlow(other);
+    }
+    void negate() {
+        if (isSmall() && word != INT64_MIN) {
+            word = -word;
+            return;
+        }
+        negateSlow();
+    }
+
+    // 两个内联值直接构造结果，不经过拷贝
+    friend Coefficient operator+(const Coefficient& a, const Coefficient& b) {
+        std::int64_t r;
+        if (a.isSmall() && b.isSmall() && !__builtin_add_overflow(a.word, b.word, &r)) return fromWord(r);
+        return sumSlow(a, b);
+    }
+    friend Coefficient operator*(const Coefficient& a, const Coefficient& b) {
+        std::int64_t r;
+        if (a.isSmall() && b.isSmall() && !__builtin_mul_overflow(a.word, b.word >> 1, &r)) return fromWord(r);
+        return productSlow(a, b);
+    }
+
+    bool operator==(const Coefficient& other) const {
+        if (isSmall() && other.isSmall()) return word == other.word;
+        return equalSlow(other);
+    }
+    bool operator!=(const Coefficient& other) const { return !(*this == other); }
+    bool operator<(const Coefficient& other) const {
+        if (isSmall() && other.isSmall()) return word < other.word;
+        return compare(other) < 0;
+    }
+
+    std::string toString() const;
+    // 绝对值的十进制文本
+    std::string absString() const;
+
+    // 对素数 p 取模，结果在 [0, p)
+    std::uint64_t mod(std::uint64_t p) const;
+
+    // 追加/读取可逆的整数编码，用于结构化键
+    void encode(std::vector<std::int64_t>& out) const;
+    static Coefficient decode(const std::vector<std::int64_t>& in, size_t& pos);
+
+private:
+    static constexpr std::int64_t kMaxSmall = INT64_MAX >> 1;
+    static constexpr std::int64_t kMinSmall = INT64_MIN >> 1;
+
+    // 符号 + 以 2^32 为基的绝对值（低位在前，无前导 0）
+    struct Big {
+        bool negative = false;
+        std::vector<std::uint32_t> mag;
+        std::uint64_t hash = 0; // |value| mod kHashPrime，由 assign 计算，就地加减时随之更新
+    };
+
+    // 偶数：内联值左移一位；奇数：Big 指针 | 1
+    std::int64_t word;
+
+    static Coefficient fromWord(std::int64_t w) {
+        Coefficient c;
+        c.word = w;
+        return c;
+    }
+    std::int64_t smallValue() const { return word >> 1; }
+    Big* big() const { return reinterpret_cast<Big*>(static_cast<std::uintptr_t>(word) & ~std::uintptr_t(1)); }
+
+    Big toBig() const;
+    void assign(Big value); // 规范化：能放入内联范围时退回内联形式，否则计算 hash
+    // 绝对值的各位（以 2^32 为基，低位在前）；内联值写入 buf
+    const std::uint32_t* limbs(std::uint32_t (&buf)[2], size_t& count) const;
+    // 本身是大数且 |other| <= |this| 时就地加上 other，只改动进位/借位经过的低位；否则返回 false
+    bool addInPlace(const Coefficient& other);
+    void assignLarge(std::int64_t value);
+    void copyBig(const Coefficient& other);
+    void release();
+    int compare(const Coefficient& other) const;
+    Coefficient& addSlow(const Coefficient& other);
+    Coefficient& mulSlow(const Coefficient& other);
+    static Coefficient sumSlow(const Coefficient& a, const Coefficient& b);
+    static Coefficient productSlow(const Coefficient& a, const Coefficient& b);
+    void negateSlow();
+    bool equalSlow(const Coefficient& other) const;
+};
+
+#endif // COEFFICIENT_H
@@ -0,0 +1,160 @@
+/**
+ * @file CountingNew.cpp
+ * @brief Replaces the global operator new/delete with versions that report to PerfStats.
+ *
+ * Replacing operator new affects the whole program, so this file is not part of the library
+ * objects: the Makefile links it only into ./main (for the allocation counts of --stats) and
+ * into the benchmarks that measure allocations. Binaries without it keep the standard
+ * allocator and report zero allocations.
+ *
+ * Every replaceable form is defined (plain, array, nothrow, aligned, sized delete), so memory
+ * is always obtained with malloc/aligned_alloc and released with free, whichever form a
+ * library uses. Allocations are counted only while collection is enabled, so the cost is one
+ * flag check otherwise.
+ */
+#include "PerfStats.h"
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+// align 为 0 时使用 malloc 的默认对齐
+void *allocate(std::size_t size, std::size_t align)
+{
+    if (PerfStats::enabled())
+        PerfStats::addAllocation(size);
+    if (size == 0)
+        size = 1;
+    // aligned_alloc 要求大小是对齐的整数倍
+    if (align != 0)
+    {
+        if (size > SIZE_MAX - align)
+            throw std::bad_alloc();
+        size = (size + align - 1) / align * align;
+    }
+    for (;;)
+    {
+        if (void *p = align != 0 ? std::aligned_alloc(align, size) : std::malloc(size))
+            return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+void *allocateNothrow(std::size_t size, std::size_t align) noexcept
+{
+    try
+    {
+        return allocate(size, align);
+    }
+    catch (const std::bad_alloc &)
+    {
+        return nullptr;
+    }
+}
+
+} // namespace
+
+void *operator new(std::size_t size)
+{
+    return allocate(size, 0);
+}
+
+void *operator new[](std::size_t size)
+{
+    return allocate(size, 0);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return allocateNothrow(size, 0);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return allocateNothrow(size, 0);
+}
+
+void *operator new(std::size_t size, std::align_val_t align)
+{
+    return allocate(size, static_cast<std::size_t>(align));
+}
+
+void *operator new[](std::size_t size, std::align_val_t align)
+{
+    return allocate(size, static_cast<std::size_t>(align));
+}
+
+void *operator new(std::size_t size, std::align_val_t align, const std::nothrow_t &) noexcept
+{
+    return allocateNothrow(size, static_cast<std::size_t>(align));
+}
+
+void *operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t &) noexcept
+{
+    return allocateNothrow(size, static_cast<std::size_t>(align));
+}
+
+// 所有形式都由 malloc 或 aligned_alloc 分配，统一用 free 释放
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    std::free(p);
+}
@@ -1,213 +1,413 @@
 /**
  * @file EqualityChecker.cpp
- * @brief Implements the static method for comparing expressions.
+ * @brief Implements expression standardization and the equality checks built on it.
  *
- * The core logic in this file involves calling the Normalize() method on the root nodes
- * of the two input ASTs. The simple equality judgment relies entirely on the
- * successful and deterministic normalization of expressions that are algebraically equivalent
- * under the defined rules (e.g., 1+x == x+1).
+ * standardize() reduces a tree (shared_ptr or AstArena) to a canonical Polynomial: like
+ * terms are merged, products and constant powers are expanded within the configured limits,
+ * and functions, quotients and unexpanded powers are interned as opaque symbols. areEqual()
+ * compares the two canonical Polynomials directly, without producing text; their 128-bit
+ * fingerprints (see Fingerprint.h) are compared first, so different expressions are usually
+ * rejected without looking at the terms. check() first runs the random evaluation of
+ * RandomEvaluator and standardizes only when an exact verdict is required.
  */
 
 // EqualityChecker.cpp
 
 #include "EqualityChecker.h"
+#include "SymbolTable.h"
+#include "Parser.h"
+#include "PerfStats.h"
 #include <algorithm>
-#include <typeinfo>
-
-//将标准化后的多项式转为唯一字符串
-std::string polyToString(const std::vector<Term>& poly) {
-    if (poly.empty()) return "0";
-
-    std::string s = "";
-    for (size_t i = 0; i < poly.size(); ++i) {
-        const auto& term = poly[i];
-
-        // 正数系数
-        if (term.coeff > 0 && i > 0) s += "+";
-        // 负数系数
-        if (term.coeff < 0) s += "-"; 
-        int absCoeff = std::abs(term.coeff);
-        std::string termStr = "";
-        // 如果系数不是 1/-1，或者没有变量因子，则显示系数
-        if (absCoeff != 1 || term.vars.empty()) {
-            termStr += std::to_string(absCoeff);
-        }
-        
-        // 连接所有变量因子
-        for (const auto& var : term.vars) {
-            if (!termStr.empty() && isdigit(termStr.back())) termStr += "*"; // 可选：加乘号
-            termStr += var;
+#include <atomic>
+
+// 以下多项式运算由 shared_ptr 树和 AstArena 两种表示共用。
+// 中间结果只在哈希索引中合并同类项而不排序，需要规范形式时才调用 canonicalize()
+
+static Polynomial numberPoly(const std::string& value) {
+    Polynomial poly;
+    // factors 为空；0 用空多项式表示，保证作为函数参数等时结构唯一
+    // 任意长度的整数字面量都不会溢出
+    Coefficient coeff = Coefficient::fromString(value);
+    if (!coeff.isZero()) poly.add(Term{std::move(coeff), {}});
+    return poly;
+}
+
+// 变量与不可分解的整体都是系数为 1 的单个符号，point 是符号的坐标
+static Polynomial symbolPoly(SymbolId id, const Fingerprint& point) {
+    Polynomial poly;
+    poly.add(Term{1, {id}, point});
+    return poly;
+}
+
+static Polynomial variablePoly(std::string_view name) {
+    Fingerprint point;
+    SymbolId id = SymbolTable::global().variable(name, &point);
+    return symbolPoly(id, point);
+}
+
+static std::atomic<int> maxExpandExponent{EqualityChecker::kDefaultMaxExpandExponent};
+static std::atomic<size_t> maxExpandTerms{EqualityChecker::kDefaultMaxExpandTerms};
+
+// 展开 base^exp 的结果至多有 C(n+exp-1, exp) 项（n 为 base 的项数），超过上限则不展开
+static bool canExpand(const Polynomial& base, int exp) {
+    if (exp < 0 || exp > maxExpandExponent.load(std::memory_order_relaxed)) return false;
+    size_t limit = maxExpandTerms.load(std::memory_order_relaxed);
+    size_t n = base.size();
+    double bound = 1;
+    for (int k = 1; k <= exp && bound <= limit; ++k) {
+        bound = bound * double(n + k - 1) / k;
+    }
+    return bound <= double(limit);
+}
+
+// 常数的幂不增加项数，不受上述上限约束，只限制结果的位数
+constexpr size_t kMaxFoldedPowerBits = 1 << 16;
+
+static bool canFold(const Coefficient& base, int exp) {
+    if (exp < 0) return false;
+    if (base.isZero() || base.isUnit()) return true;
+    return static_cast<size_t>(exp) <= kMaxFoldedPowerBits / base.bitLength();
+}
+
+// 结果写回 leftPoly；rightPoly 随后即被丢弃，可以被移走
+static void combineBinary(TokenType op, Polynomial& leftPoly, Polynomial& rightPoly) {
+    if (op == TokenType::PLUS) {
+        leftPoly.add(std::move(rightPoly));
+    } 
+    else if (op == TokenType::MINUS) {
+        leftPoly.add(std::move(rightPoly), -1);
+    }
+    else if (op == TokenType::MUL) {
+        leftPoly = multiply(leftPoly, rightPoly);
+    }        
+    else if (op == TokenType::POW) {
+        // 指数为非负整数常数时展开：常数底数只受结果位数的限制，含变量的底数受指数和项数上限的限制
+        Coefficient constant, base;
+        int exp = 0;
+        if (rightPoly.isConstant(constant) && constant.toInt(exp) &&
+            (leftPoly.isConstant(base) ? canFold(base, exp) : canExpand(leftPoly, exp))) {
+            leftPoly = power(leftPoly, exp);
+            return;
         }
-        s += termStr;
-    }
-    
-    if (s.empty()) return "0";
-    return s;
-}
-
-void sortAndMerge(std::vector<Term>& terms) {
-    std::sort(terms.begin(), terms.end());
-    // 合并同类项
-    std::vector<Term> merged;
-    for (const auto& term : terms) {
-        if (!merged.empty() && merged.back().isSameVars(term)) {
-            merged.back().coeff += term.coeff;
-        } else {
-            merged.push_back(term);
+
+        // 如果无法展开，整体驻留为一个符号
+        PerfStats::addOpaqueAtom();
+        Fingerprint point;
+        SymbolId id = SymbolTable::global().power(leftPoly.canonicalize(), rightPoly.canonicalize(), &point);
+        leftPoly = symbolPoly(id, point);
+    }
+    else if (op == TokenType::DIV) {
+        PerfStats::addOpaqueAtom();
+        Fingerprint point;
+        SymbolId id = SymbolTable::global().quotient(leftPoly.canonicalize(), rightPoly.canonicalize(), &point);
+        leftPoly = symbolPoly(id, point);
+    }
+    else {
+        leftPoly = Polynomial();
+    }
+}
+
+// 结果写回 argPoly
+static void applyFunction(TokenType funcType, Polynomial& argPoly) {
+    PerfStats::addOpaqueAtom();
+    Fingerprint point;
+    SymbolId id = SymbolTable::global().function(funcType, argPoly.canonicalize(), &point);
+    argPoly = symbolPoly(id, point);
+}
+
+// 后序遍历中的归约：子节点的结果在 values 栈顶，原地替换为本节点的结果
+static void reduceUnary(std::vector<Polynomial>& values, TokenType op) {
+    if (op == TokenType::MINUS) {
+        // 取反
+        values.back().negate();
+    }
+}
+
+static void reduceBinary(std::vector<Polynomial>& values, TokenType op) {
+    combineBinary(op, values[values.size() - 2], values.back());
+    values.pop_back();
+}
+
+static void reduceFunction(std::vector<Polynomial>& values, TokenType funcType) {
+    applyFunction(funcType, values.back());
+}
+
+static bool isLeaf(const ASTNode& node) {
+    return node.kind == NodeKind::Number || node.kind == NodeKind::Variable;
+}
+
+void StandardizeMemo::countSubtrees(const ASTNode& root) {
+    // 重复出现的子树会整体命中缓存，不必再统计其内部
+    walkPostOrder(
+        root, [&](const ASTNode& node) { return occurrences[node.hash]++ == 0; }, [](const ASTNode&) {});
+}
+
+bool StandardizeMemo::isRepeated(const ASTNode& node) const {
+    auto it = occurrences.find(node.hash);
+    return it != occurrences.end() && it->second > 1;
+}
+
+const Polynomial* StandardizeMemo::lookup(const ASTNode& node) {
+    auto it = entries.find(node.hash);
+    if (it != entries.end()) {
+        // 哈希相同还需确认结构相同
+        for (const auto& entry : it->second) {
+            if (sameStructure(*entry.node, node)) {
+                ++hitCount;
+                return &entry.poly;
+            }
         }
     }
-    // 移除系数为0的项
-    merged.erase(std::remove_if(merged.begin(), merged.end(),
-                                [](const Term& t) { return t.coeff == 0; }),
-                 merged.end());
-    terms = std::move(merged);
+    ++missCount;
+    return nullptr;
 }
 
-std::vector<Term> EqualityChecker::standardize(const std::shared_ptr<ASTNode>& node) {
-    std::vector<Term> result;
-    if (!node) return result;
+void StandardizeMemo::insert(const ASTNode& node, const Polynomial& poly) {
+    entries[node.hash].push_back({&node, poly});
+}
+
+void StandardizeMemo::clear() {
+    occurrences.clear();
+    entries.clear();
+    hitCount = 0;
+    missCount = 0;
+}
 
-    //数字节点
-    if (auto n = std::dynamic_pointer_cast<NumberNode>(node)) {//检测具体的指针类型
-        Term t;
-        t.coeff = std::stoi(n->value);
-        // factors 为空
-        result.push_back(t);
+static Polynomial standardizeDeep(const ASTNode& root, StandardizeMemo* memo);
+
+namespace {
+
+// 浅层子树直接递归（常见情况，结果按值返回，没有显式栈的开销）；
+// 超过 kMaxRecursion 层后，剩下的子树交给 standardizeDeep 用显式栈处理，树再深也不会压满调用栈
+constexpr int kMaxRecursion = 256;
+
+// 通过 visitNode 按节点种类分派，递归时直接传引用，不触碰 shared_ptr 引用计数
+struct Standardizer {
+    StandardizeMemo* memo = nullptr;
+    int depth = 0;
+
+    Polynomial run(const ASTNode& node) {
+        if (depth >= kMaxRecursion) return standardizeDeep(node, memo);
+        // 叶子节点直接计算比查缓存更便宜
+        if (!memo || isLeaf(node) || !memo->isRepeated(node)) {
+            return dispatch(node);
+        }
+        if (const Polynomial* cached = memo->lookup(node)) {
+            return *cached;
+        }
+        auto result = dispatch(node);
+        memo->insert(node, result);
         return result;
     }
 
-    // 变量节点
-    if (auto v = std::dynamic_pointer_cast<VariableNode>(node)) {
-        Term t;
-        t.coeff = 1;
-        t.vars.push_back(v->name);
-        result.push_back(t);
+    Polynomial dispatch(const ASTNode& node) {
+        ++depth;
+        auto result = visitNode(node, *this);
+        --depth;
         return result;
     }
 
-    // 一元函数节点
-    if (auto u = std::dynamic_pointer_cast<UnaryOpNode>(node)) {
-        auto argPoly = standardize(u->right);
-        if (u->op == TokenType::MINUS) {
+    Polynomial operator()(const NumberNode& n) {
+        return numberPoly(n.value);
+    }
+    Polynomial operator()(const VariableNode& v) {
+        return variablePoly(v.name);
+    }
+    Polynomial operator()(const UnaryOpNode& u) {
+        auto result = run(*u.right);
+        if (u.op == TokenType::MINUS) {
             // 取反
-            for (auto& term : argPoly) term.coeff *= -1;
+            result.negate();
         }
-        result = argPoly;
-        sortAndMerge(result);
         return result;
     }
+    Polynomial operator()(const BinaryOpNode& b) {
+        auto left = run(*b.left);
+        auto right = run(*b.right);
+        combineBinary(b.op, left, right);
+        return left;
+    }
+    // 函数节点 (sin, cos...)
+    Polynomial operator()(const FunctionNode& f) {
+        auto result = run(*f.arg);
+        applyFunction(f.funcType, result);
+        return result;
+    }
+};
 
-    // 二元运算节点
-    if (auto b = std::dynamic_pointer_cast<BinaryOpNode>(node)) {
-        auto leftPoly = standardize(b->left);
-        auto rightPoly = standardize(b->right);
+// standardizeDeep 的归约：walkPostOrder 离开节点时分派，子节点的结果取自 values 栈顶
+struct StackReducer {
+    std::vector<Polynomial>& values;
 
-        if (b->op == TokenType::PLUS) {
-            result = leftPoly;
-            result.insert(result.end(), rightPoly.begin(), rightPoly.end());
-        } 
-        else if (b->op == TokenType::MINUS) {
-            for (auto& term : rightPoly) term.coeff *= -1;
-            result = leftPoly;
-            result.insert(result.end(), rightPoly.begin(), rightPoly.end());
-        }
-        else if (b->op == TokenType::MUL) {
-            for (const auto& l : leftPoly) {
-                for (const auto& r : rightPoly) {
-                    Term newTerm;
-                    newTerm.coeff = l.coeff * r.coeff;
-                    newTerm.vars = l.vars;
-                    newTerm.vars.insert(newTerm.vars.end(), r.vars.begin(), r.vars.end());
-                    std::sort(newTerm.vars.begin(), newTerm.vars.end());
-                    result.push_back(newTerm);
-                }
+    void operator()(const NumberNode& n) const {
+        values.push_back(numberPoly(n.value));
+    }
+    void operator()(const VariableNode& v) const {
+        values.push_back(variablePoly(v.name));
+    }
+    void operator()(const UnaryOpNode& u) const {
+        reduceUnary(values, u.op);
+    }
+    void operator()(const BinaryOpNode& b) const {
+        reduceBinary(values, b.op);
+    }
+    void operator()(const FunctionNode& f) const {
+        reduceFunction(values, f.funcType);
+    }
+};
+
+} // namespace
+
+// 非递归的标准化，中间结果放在 values 栈中，调用栈深度与树高无关
+static Polynomial standardizeDeep(const ASTNode& root, StandardizeMemo* memo) {
+    ScratchVector<Polynomial> scratch;
+    std::vector<Polynomial>& values = scratch.items;
+    StackReducer reduce{values};
+    if (!memo) {
+        walkPostOrder(root, [](const ASTNode&) { return true; }, [&](const ASTNode& node) { visitNode(node, reduce); });
+        return std::move(values.back());
+    }
+
+    // 未命中缓存的重复子树，离开时把结果写入缓存；子树按后序完成，所以最近进入的总是最先离开
+    ScratchVector<const ASTNode*> pendingInsert;
+    std::vector<const ASTNode*>& toInsert = pendingInsert.items;
+    walkPostOrder(
+        root,
+        [&](const ASTNode& node) {
+            if (isLeaf(node) || !memo->isRepeated(node)) return true;
+            if (const Polynomial* cached = memo->lookup(node)) {
+                values.push_back(*cached);
+                return false;
             }
-        }        
-        else if (b->op == TokenType::POW) {
-            // 检查指数是否为整数 2 或 3
-            bool expanded = false;
-            if (rightPoly.size() == 1 && rightPoly[0].vars.empty()) { 
-                int exp = rightPoly[0].coeff;
-                if (exp == 2 || exp == 3) {
-                    std::vector<Term> currentPoly = leftPoly; // Base^1
-                    
-                    for (int k = 1; k < exp; ++k) {
-                        std::vector<Term> nextPoly;
-                        for (const auto& t1 : currentPoly) {
-                            for (const auto& t2 : leftPoly) {
-                                Term newTerm;
-                                newTerm.coeff = t1.coeff * t2.coeff;
-                                newTerm.vars = t1.vars;
-                                newTerm.vars.insert(newTerm.vars.end(), t2.vars.begin(), t2.vars.end());
-                                // 变量排序以保证唯一性
-                                std::sort(newTerm.vars.begin(), newTerm.vars.end());
-                                nextPoly.push_back(newTerm);
-                            }
-                        }
-                        currentPoly = nextPoly;
-                    }
-                    result = currentPoly;
-                    expanded = true;
-                }
+            toInsert.push_back(&node);
+            return true;
+        },
+        [&](const ASTNode& node) {
+            visitNode(node, reduce);
+            if (!toInsert.empty() && toInsert.back() == &node) {
+                memo->insert(node, values.back());
+                toInsert.pop_back();
             }
+        });
+    return std::move(values.back());
+}
 
-            // 如果无法展开回退到字符串拼接
-            if (!expanded) {
-                std::string leftStr = polyToString(leftPoly);
-                std::string rightStr = polyToString(rightPoly);
-                std::string combinedStr = "(" + leftStr + ")^(" + rightStr + ")";
-                Term t;
-                t.coeff = 1;
-                t.vars.push_back(combinedStr);
-                result.push_back(t);
-            }
-        }
-        else if (b->op == TokenType::DIV) {
-             std::string leftStr = polyToString(leftPoly);
-             std::string rightStr = polyToString(rightPoly);
-             std::string combinedStr = "(" + leftStr + ")/(" + rightStr + ")";
-             Term t;
-             t.coeff = 1;
-             t.vars.push_back(combinedStr);
-             result.push_back(t);
+static Polynomial standardizeArena(const AstArena& arena, NodeId root) {
+    if (root == kNullNode) return Polynomial();
+
+    ScratchVector<Polynomial> scratch;
+    std::vector<Polynomial>& values = scratch.items;
+    walkPostOrder(arena, root, [](NodeId) { return true; }, [&](NodeId id) {
+        const FlatNode& node = arena[id];
+        switch (node.kind) {
+            case NodeKind::Number:
+                values.push_back(numberPoly(std::string(arena.text(id))));
+                break;
+            case NodeKind::Variable:
+                values.push_back(variablePoly(arena.text(id)));
+                break;
+            case NodeKind::UnaryOp:
+                reduceUnary(values, node.op);
+                break;
+            case NodeKind::BinaryOp:
+                reduceBinary(values, node.op);
+                break;
+            case NodeKind::Function:
+                reduceFunction(values, node.op);
+                break;
         }
+    });
+    return std::move(values.back());
+}
 
-        sortAndMerge(result); 
-        return result;
-    }
+Polynomial EqualityChecker::standardize(const std::shared_ptr<ASTNode>& node) {
+    if (!node) return {};
+    PerfStats::Timer timer(Phase::Standardize);
+    Polynomial result = Standardizer{}.run(*node);
+    result.canonicalize();
+    return result;
+}
 
-    // 函数节点 (sin, cos...)
-    if (auto f = std::dynamic_pointer_cast<FunctionNode>(node)) {
-        auto argPoly = standardize(f->arg);
-        std::string argStr = polyToString(argPoly);
-        std::string funcName = "";
-        if (f->funcType == TokenType::SIN) funcName = "sin";
-        else if (f->funcType == TokenType::COS) funcName = "cos";
-        else if (f->funcType == TokenType::TAN) funcName = "tan";
-        else if (f->funcType == TokenType::COT) funcName = "cot";
-        else if (f->funcType == TokenType::LN) funcName = "ln";
-        else if (f->funcType == TokenType::SQRT) funcName = "sqrt";
-        else funcName = "unknown_func";
-        
-        Term t;
-        t.coeff = 1;
-        t.vars.push_back(funcName + "(" + argStr + ")");
-        result.push_back(t);
-        return result;
-    }
-    else{
-        throw std::runtime_error("Unsupported node type");
-    }
+Polynomial EqualityChecker::standardize(const std::shared_ptr<ASTNode>& node, StandardizeMemo& memo) {
+    if (!node) return {};
+    PerfStats::Timer timer(Phase::Standardize);
+    Polynomial result = Standardizer{&memo}.run(*node);
+    result.canonicalize();
+    return result;
+}
+
+Polynomial EqualityChecker::standardize(const AstArena& arena, NodeId id) {
+    PerfStats::Timer timer(Phase::Standardize);
+    Polynomial result = standardizeArena(arena, id);
+    result.canonicalize();
+    return result;
 }
 
 std::string EqualityChecker::getStandardizedString(const std::shared_ptr<ASTNode>& expr) {
+    PolyArena arena;
     auto poly = standardize(expr);
     return polyToString(poly);
 }
 
+std::string EqualityChecker::getStandardizedString(const AstArena& arena, NodeId root) {
+    PolyArena polyArena;
+    return polyToString(standardize(arena, root));
+}
+
+Fingerprint EqualityChecker::getFingerprint(const std::shared_ptr<ASTNode>& expr) {
+    PolyArena arena;
+    return standardize(expr).fingerprint();
+}
+
+Fingerprint EqualityChecker::getFingerprint(const AstArena& arena, NodeId root) {
+    PolyArena polyArena;
+    return standardize(arena, root).fingerprint();
+}
+
+void EqualityChecker::setExpansionLimits(int maxExponent, size_t maxTerms) {
+    maxExpandExponent.store(maxExponent, std::memory_order_relaxed);
+    maxExpandTerms.store(maxTerms, std::memory_order_relaxed);
+}
+
+std::uint64_t EqualityChecker::rulesFingerprint() {
+    // 覆盖交换律/结合律、取反、乘法展开、幂的展开与上限、整体（函数、除法、幂）的记法和大整数系数
+    static const char* const probes[] = {
+        "1+x",          "x*y-y*x",        "-(a-b)*(a+b)",   "(x+y)^3",           "(x-1)^16",
+        "(x+1)^17",     "x^y^2",          "-x^2",           "sin x^2+cos(x)^2",  "tan(2x)/cot(y)",
+        "ln(x)*sqrt(y)", "x/y+y/x",       "2^70*x-3^40",    "(a+b)(a-b)c",       "0*x+0",
+    };
+    std::uint64_t h = hashMix(kCanonicalFormVersion, static_cast<std::size_t>(maxExpandExponent.load()));
+    h = hashMix(h, maxExpandTerms.load());
+    for (const char* probe : probes) {
+        Lexer lexer(probe);
+        Parser parser(lexer);
+        AstArena arena;
+        NodeId root = parser.parse(arena);
+        h = hashMix(h, hashText(getStandardizedString(arena, root)));
+    }
+    return h;
+}
+
 bool EqualityChecker::areEqual(const std::shared_ptr<ASTNode>& expr1, const std::shared_ptr<ASTNode>& expr2) {
-    std::string standardizedExpr1 = getStandardizedString(expr1);
-    std::string standardizedExpr2 = getStandardizedString(expr2);
-    std::cout << "Standardized expressions: " << standardizedExpr1 << " and " << standardizedExpr2 << std::endl;
-    return standardizedExpr1 == standardizedExpr2;
-}
\ No newline at end of file
+    // 所有中间多项式（包括缓存中的副本）都在 arena 中分配，返回时一次性释放；memo 必须先于 arena 析构
+    PolyArena arena;
+    StandardizeMemo memo;
+    return areEqual(expr1, expr2, memo);
+}
+
+bool EqualityChecker::areEqual(const std::shared_ptr<ASTNode>& expr1, const std::shared_ptr<ASTNode>& expr2,
+                               StandardizeMemo& memo) {
+    if (expr1) memo.countSubtrees(*expr1);
+    if (expr2) memo.countSubtrees(*expr2);
+    auto poly1 = standardize(expr1, memo);
+    auto poly2 = standardize(expr2, memo);
+    // 规范多项式按符号 ID 排序且已合并，结构相同即相等
+    return poly1 == poly2;
+}
+
+EqualityVerdict EqualityChecker::check(const std::shared_ptr<ASTNode>& expr1, const std::shared_ptr<ASTNode>& expr2,
+                                       bool requireExact, const RandomEvaluator& evaluator) {
+    EqualityVerdict verdict = evaluator.compare(expr1, expr2);
+    if (verdict != EqualityVerdict::ProbablyEqual || !requireExact) return verdict;
+    return areEqual(expr1, expr2) ? EqualityVerdict::Equal : EqualityVerdict::Different;
+}
@@ -4,7 +4,8 @@
  *
  * This class provides a static interface for determining the mathematical equivalence
  * of two simple expressions, based on the project requirements. The check is performed
- * by comparing the canonical (normalized) string representations of their respective ASTs.
+ * by comparing the canonical Polynomials of their ASTs; check() can answer with a random
+ * evaluation (RandomEvaluator) instead.
  */
 
 // filepath: 
@@ -12,36 +13,82 @@
 #define EQUALITYCHECKER_H
 
 #include "AST.h"
+#include "AstArena.h"
+#include "Polynomial.h"
+#include "RandomEvaluator.h"
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <cstdint>
 #include <sstream>
+#include <unordered_map>
 
-// 代表多项式中的一项
-struct Term {
-    int coeff; 
-    std::vector<std::string> vars;
-
-    // 排序：先比变量部分，再比系数
-    bool operator<(const Term& other) const {
-        if (vars != other.vars) return vars < other.vars;
-        return coeff < other.coeff;
-    }
-    
-    // 判断变量部分是否相同（用于合并同类项）
-    bool isSameVars(const Term& other) const {
-        return vars == other.vars;
-    }
+// 子树标准化结果的缓存，按结构哈希索引。
+// countSubtrees() 先统计各子树的出现次数，只有出现不止一次的子树才会被缓存，
+// 因此只出现一次的长链（如 a1+a2+...+an 的左脊）不会产生额外的拷贝。
+class StandardizeMemo {
+public:
+    void countSubtrees(const ASTNode& root);
+    bool isRepeated(const ASTNode& node) const;
+    // 命中时返回缓存的多项式，并计入 hits；否则计入 misses
+    const Polynomial* lookup(const ASTNode& node);
+    void insert(const ASTNode& node, const Polynomial& poly);
+
+    size_t hits() const { return hitCount; }
+    size_t misses() const { return missCount; }
+    void clear();
+
+private:
+    struct Entry {
+        const ASTNode* node;
+        Polynomial poly;
+    };
+    std::unordered_map<std::size_t, int> occurrences;
+    std::unordered_map<std::size_t, std::vector<Entry>> entries;
+    size_t hitCount = 0;
+    size_t missCount = 0;
 };
 
 class EqualityChecker {
 public:
+    // 幂运算展开的默认上限：指数不超过 16，且展开结果的项数上界不超过 100000。
+    // 底数为常数时不受这两个上限约束（结果只有一项），直接算出不超过 65536 位的整数
+    static constexpr int kDefaultMaxExpandExponent = 16;
+    static constexpr size_t kDefaultMaxExpandTerms = 100000;
+    // 调整上限；超过上限的幂运算回退为不可分解的整体
+    static void setExpansionLimits(int maxExponent, size_t maxTerms);
+
+    // 标准化规则的版本号：修改了规范形式的写法（项的顺序、系数格式、整体的记法等）时加一
+    static constexpr std::uint32_t kCanonicalFormVersion = 2;
+    // 标准化规则的指纹：由版本号、当前的展开上限以及一组固定探针表达式的规范形式哈希得到。
+    // 算法的输出一旦改变（即使忘了改版本号），探针的结果通常也会变，依赖规范形式的持久缓存据此失效
+    static std::uint64_t rulesFingerprint();
+
+    // 中间多项式在本次调用的 PolyArena 中分配，返回时整体释放
     static bool areEqual(const std::shared_ptr<ASTNode>& expr1, const std::shared_ptr<ASTNode>& expr2);
+    // 两边共享同一个 memo，每个不同的重复子树在一次比较中只标准化一次；
+    // memo 由调用方持有，因此这里不开 PolyArena（调用方可以自己开，但 memo 不能活得比它久）
+    static bool areEqual(const std::shared_ptr<ASTNode>& expr1, const std::shared_ptr<ASTNode>& expr2,
+                         StandardizeMemo& memo);
+    // 先在随机点上取值比较（与树的大小成线性）；只有要求精确结论且取值全部相同时才完全展开。
+    // 返回 Different、ProbablyEqual（未要求精确）或 Equal
+    static EqualityVerdict check(const std::shared_ptr<ASTNode>& expr1, const std::shared_ptr<ASTNode>& expr2,
+                                 bool requireExact, const RandomEvaluator& evaluator = RandomEvaluator());
     // 返回标准化后的字符串，用于判断是否正确排序以及比较两个表达式是否相等
     static std::string getStandardizedString(const std::shared_ptr<ASTNode>& expr); 
-private:
-    //将 AST 转换为规范化的多项式形式 (排序后的项列表)
-    static std::vector<Term> standardize(const std::shared_ptr<ASTNode>& node);    
+    static std::string getStandardizedString(const AstArena& arena, NodeId root);
+    // 标准化结果的 128 位指纹（见 Fingerprint.h），不生成文本；规范形式相同当且仅当指纹相同（除极小概率的碰撞）
+    static Fingerprint getFingerprint(const std::shared_ptr<ASTNode>& expr);
+    static Fingerprint getFingerprint(const AstArena& arena, NodeId root);
+
+    //将 AST 转换为规范化的多项式形式 (已 canonicalize 的项列表)
+    // 结果来自调用时的当前资源（见 PolyArena.h），不能移出调用方的 PolyArena
+    // 树的深度不受调用栈限制：浅层递归，过深的子树改用显式栈
+    static Polynomial standardize(const std::shared_ptr<ASTNode>& node);    
+    // 使用 memo 复用重复子树的结果；调用前需对 node 调用过 memo.countSubtrees
+    static Polynomial standardize(const std::shared_ptr<ASTNode>& node, StandardizeMemo& memo);
+    // 直接在 AstArena 上标准化，结果与 shared_ptr 版本相同
+    static Polynomial standardize(const AstArena& arena, NodeId node);
 };
 
 #endif // EQUALITYCHECKER_H
\ No newline at end of file
@@ -0,0 +1,102 @@
+/**
+ * @file Fingerprint.h
+ * @brief Declares the 128-bit fingerprint of polynomials.
+ *
+ * The fingerprint of a polynomial is its value at a fixed pseudo-random point, taken twice
+ * modulo p = 2^61 - 1 at two independent points and stored as two 64-bit words. A symbol's
+ * coordinates come from its content, never from its SymbolId: a variable's from its name,
+ * an opaque atom's from its kind and the fingerprints of its operands (see SymbolTable).
+ * Fingerprints are therefore the same in every process, whatever order symbols were
+ * interned in, and can be stored or used as keys in place of the canonical text.
+ *
+ * Evaluation respects + and *, so a Polynomial keeps its fingerprint up to date as terms
+ * are merged (one multiply-add per added term) and multiply() gets the product's for free.
+ *
+ * Reducing coefficients modulo p alone would make p·x and 0 (or (p+1)/2·x and -(p-1)/2·x)
+ * collide at every point. Coefficients below 2^60 in absolute value differ by less than p,
+ * so their residues tell them apart. Every term whose coefficient c is at least 2^60 in
+ * absolute value also adds wide(c)·m, where m is the monomial's value and wide(c) is a hash
+ * of the exact value of c with the sign of c. The hash starts from |c| modulo a second prime
+ * (Coefficient::magnitudeHash), which the coefficient keeps as it changes, so a polynomial
+ * updates this part in O(1) whenever a coefficient crosses or changes above 2^60.
+ *
+ * Equal polynomials always have equal fingerprints. Two different polynomials of total
+ * degree d collide with probability at most (d/p)^2 over the choice of points and hashes,
+ * whatever their coefficients. The points are fixed, though, so inputs can be built to
+ * collide on purpose, and exact comparisons (Polynomial::operator==) use the fingerprint
+ * only to reject.
+ */
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include "Coefficient.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct Fingerprint {
+    static constexpr std::uint64_t kPrime = (std::uint64_t(1) << 61) - 1;
+
+    std::uint64_t a = 0; // 第一个取值点上的值，在 [0, kPrime) 中
+    std::uint64_t b = 0; // 第二个取值点上的值
+
+    // 常数多项式的指纹
+    static Fingerprint constant(const Coefficient& c) {
+        std::uint64_t r = c.mod(kPrime);
+        return {r, r};
+    }
+
+    // 绝对值不小于 2^60 的系数另加的取值（见文件头）；对系数是奇函数，其余系数为 0
+    static Fingerprint wide(const Coefficient& c) {
+        if (c.isNarrow()) return {};
+        std::uint64_t h = c.magnitudeHash();
+        Fingerprint f{(h ^ (h >> 29)) * 0xbf58476d1ce4e5b9ULL % kPrime, (h ^ (h >> 32)) * 0x94d049bb133111ebULL % kPrime};
+        return c.sign() < 0 ? -f : f;
+    }
+    // 系数为 c、单项式取值为 monomial 的一项的指纹
+    static Fingerprint term(const Coefficient& c, const Fingerprint& monomial) {
+        return (constant(c) + wide(c)) * monomial;
+    }
+
+    bool isZero() const { return a == 0 && b == 0; }
+    bool operator==(const Fingerprint& other) const { return a == other.a && b == other.b; }
+    bool operator!=(const Fingerprint& other) const { return !(*this == other); }
+
+    Fingerprint operator+(const Fingerprint& other) const { return {addMod(a, other.a), addMod(b, other.b)}; }
+    Fingerprint operator-(const Fingerprint& other) const { return {subMod(a, other.a), subMod(b, other.b)}; }
+    Fingerprint operator-() const { return Fingerprint() - *this; }
+    Fingerprint operator*(const Fingerprint& other) const { return {mulMod(a, other.a), mulMod(b, other.b)}; }
+    Fingerprint& operator+=(const Fingerprint& other) { return *this = *this + other; }
+
+    // 32 位十六进制文本，先 a 后 b
+    std::string toString() const {
+        static const char digits[] = "0123456789abcdef";
+        std::string s(32, '0');
+        for (int i = 0; i < 16; ++i) {
+            s[15 - i] = digits[(a >> (4 * i)) & 15];
+            s[31 - i] = digits[(b >> (4 * i)) & 15];
+        }
+        return s;
+    }
+
+    static std::uint64_t addMod(std::uint64_t x, std::uint64_t y) {
+        std::uint64_t r = x + y;
+        return r >= kPrime ? r - kPrime : r;
+    }
+    static std::uint64_t subMod(std::uint64_t x, std::uint64_t y) { return x >= y ? x - y : x + kPrime - y; }
+    // 2^61 ≡ 1 (mod p)，高位折叠回低位即可约简
+    static std::uint64_t mulMod(std::uint64_t x, std::uint64_t y) {
+        unsigned __int128 z = static_cast<unsigned __int128>(x) * y;
+        std::uint64_t r = (static_cast<std::uint64_t>(z) & kPrime) + static_cast<std::uint64_t>(z >> 61);
+        return r >= kPrime ? r - kPrime : r;
+    }
+};
+
+// 用于 unordered_map 等：两个分量本身已近似均匀分布
+struct FingerprintHash {
+    std::size_t operator()(const Fingerprint& f) const {
+        return static_cast<std::size_t>(f.a ^ (f.b * 0x9e3779b97f4a7c15ULL));
+    }
+};
+
+#endif // FINGERPRINT_H
@@ -0,0 +1,126 @@
+/**
+ * @file GapBuffer.h
+ * @brief Declares a gap buffer: a sequence that inserts and erases in O(1) at a movable gap.
+ *
+ * The elements live in one array with an unused gap somewhere in the middle. Inserting or
+ * erasing at the gap only moves the gap's bounds; moving the gap to another position moves
+ * the elements in between, so a series of edits near one another (typing) costs time
+ * proportional to the edits, not to the length of the sequence.
+ *
+ * moveGap() can convert every element that crosses the gap. IncrementalAnalyzer uses this
+ * to store positions before the gap as absolute values and positions after it relative to
+ * the end, so an insertion at the gap shifts everything after it without touching it.
+ */
+#ifndef GAP_BUFFER_H
+#define GAP_BUFFER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+template <typename T>
+class GapBuffer
+{
+public:
+    size_t size() const { return items.size() - (gapEnd - gapBegin); }
+    bool empty() const { return size() == 0; }
+    // 间隙的位置：它前面有 gap() 个元素
+    size_t gap() const { return gapBegin; }
+
+    // 下标是逻辑位置，不含间隙
+    T &operator[](size_t i) { return items[i < gapBegin ? i : i + (gapEnd - gapBegin)]; }
+    const T &operator[](size_t i) const { return items[i < gapBegin ? i : i + (gapEnd - gapBegin)]; }
+
+    void clear()
+    {
+        items.clear();
+        gapBegin = gapEnd = 0;
+    }
+
+    // 把间隙移到 pos 前。从间隙前移到间隙后的元素调用 toAfter，反方向的调用 toBefore
+    template <typename ToAfter, typename ToBefore>
+    void moveGap(size_t pos, ToAfter &&toAfter, ToBefore &&toBefore)
+    {
+        while (gapBegin > pos)
+        {
+            T &moved = items[--gapEnd] = std::move(items[--gapBegin]);
+            toAfter(moved);
+        }
+        while (gapBegin < pos)
+        {
+            T &moved = items[gapBegin++] = std::move(items[gapEnd++]);
+            toBefore(moved);
+        }
+    }
+    void moveGap(size_t pos)
+    {
+        auto keep = [](T &) {};
+        moveGap(pos, keep, keep);
+    }
+
+    // 在间隙处插入（插入的元素位于间隙前）
+    void insert(T value)
+    {
+        if (gapBegin == gapEnd)
+            grow(1);
+        items[gapBegin++] = std::move(value);
+    }
+    template <typename It>
+    void insert(It first, It last)
+    {
+        size_t count = static_cast<size_t>(std::distance(first, last));
+        if (gapEnd - gapBegin < count)
+            grow(count);
+        gapBegin = std::copy(first, last, items.begin() + gapBegin) - items.begin();
+    }
+    // 删除间隙后的 count 个元素；腾出的位置重置为 T()，不再持有资源
+    void eraseAfter(size_t count)
+    {
+        std::fill(items.begin() + gapEnd, items.begin() + gapEnd + count, T());
+        gapEnd += count;
+    }
+    // 删除间隙前的 count 个元素
+    void eraseBefore(size_t count)
+    {
+        std::fill(items.begin() + gapBegin - count, items.begin() + gapBegin, T());
+        gapBegin -= count;
+    }
+
+    // 把间隙移到末尾，返回连续存放的全部元素
+    const T *contiguous()
+    {
+        moveGap(size());
+        return items.data();
+    }
+
+    // 把 [first, last) 复制到 out 末尾
+    template <typename Out>
+    void copy(size_t first, size_t last, Out &out) const
+    {
+        size_t split = std::min(std::max(first, gapBegin), last);
+        out.insert(out.end(), items.begin() + first, items.begin() + split);
+        size_t gapSize = gapEnd - gapBegin;
+        out.insert(out.end(), items.begin() + split + gapSize, items.begin() + last + gapSize);
+    }
+
+private:
+    std::vector<T> items; // 含间隙，[gapBegin, gapEnd) 未使用
+    size_t gapBegin = 0;
+    size_t gapEnd = 0;
+
+    // 容量至少翻倍，间隙后的元素移到新数组末尾
+    void grow(size_t needed)
+    {
+        size_t capacity = std::max({items.size() * 2, items.size() + needed, size_t(16)});
+        std::vector<T> larger(capacity);
+        std::move(items.begin(), items.begin() + gapBegin, larger.begin());
+        size_t tail = items.size() - gapEnd;
+        std::move(items.begin() + gapEnd, items.end(), larger.end() - tail);
+        gapEnd = capacity - tail;
+        items = std::move(larger);
+    }
+};
+
+#endif // GAP_BUFFER_H
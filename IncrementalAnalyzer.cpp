@@ -0,0 +1,401 @@
+/**
+ * @file IncrementalAnalyzer.cpp
+ * @brief Implements incremental re-lexing, summand splitting and re-standardization.
+ */
+#include "IncrementalAnalyzer.h"
+#include "AstArena.h"
+#include "EqualityChecker.h"
+#include "Parser.h"
+#include "PolyArena.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+bool endsOperand(TokenType type)
+{
+    return type == TokenType::INT || type == TokenType::VAR || type == TokenType::RPAREN;
+}
+
+// 切分窗口末尾之前至少留出的字符数：关键字最多向后看 4 个字符，数字多看 1 个
+constexpr size_t kLookahead = 8;
+
+// [0, count) 中第一个 before(i) 为假的下标（before 先真后假），没有时返回 count。
+// 从 hint 向两侧按倍增的步长找到包含答案的区间再二分，时间是 O(log |答案 - hint|)：
+// 连续的编辑通常挨在一起，从上次的间隙处找几乎不用走动
+template <typename Before>
+size_t searchFrom(size_t hint, size_t count, Before &&before)
+{
+    hint = std::min(hint, count);
+    size_t lo = 0, hi = count;
+    if (hint < count && before(hint))
+    {
+        lo = hint + 1;
+        for (size_t step = 1; lo < count; step *= 2)
+        {
+            size_t probe = std::min(count - 1, hint + step);
+            if (!before(probe))
+            {
+                hi = probe;
+                break;
+            }
+            lo = probe + 1;
+        }
+    }
+    else
+    {
+        hi = hint;
+        for (size_t step = 1; hi > 0; step *= 2)
+        {
+            size_t probe = hint >= step ? hint - step : 0;
+            if (before(probe))
+            {
+                lo = probe + 1;
+                break;
+            }
+            hi = probe;
+        }
+    }
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (before(mid))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+} // namespace
+
+IncrementalAnalyzer::IncrementalAnalyzer(std::string text)
+{
+    reset(std::move(text));
+}
+
+void IncrementalAnalyzer::reset(std::string text)
+{
+    if (text.size() > UINT32_MAX)
+        throw std::runtime_error("Input too large");
+    source.clear();
+    source.insert(text.begin(), text.end());
+    analyzeAll();
+}
+
+std::string IncrementalAnalyzer::text() const
+{
+    std::string out;
+    out.reserve(source.size());
+    source.copy(0, source.size(), out);
+    return out;
+}
+
+size_t IncrementalAnalyzer::tokenOffset(size_t i) const
+{
+    return i < tokens.gap() ? tokens[i].offset : source.size() - tokens[i].offset;
+}
+
+size_t IncrementalAnalyzer::summandFirst(size_t k) const
+{
+    return k < summands.gap() ? summands[k].first : tokens.size() - summands[k].first;
+}
+
+bool IncrementalAnalyzer::isImplicitMul(size_t i) const
+{
+    return tokens[i].type == TokenType::MUL && tokens[i].length == 0;
+}
+
+bool IncrementalAnalyzer::isBoundary(size_t i) const
+{
+    TokenType type = tokens[i].type;
+    return i > 0 && (type == TokenType::PLUS || (type == TokenType::MINUS && endsOperand(tokens[i - 1].type)));
+}
+
+void IncrementalAnalyzer::moveTokenGap(size_t i)
+{
+    // 绝对位置与到末尾的距离互换：两者之和是文本长度
+    std::uint32_t length = static_cast<std::uint32_t>(source.size());
+    auto flip = [length](TokenEntry &token) { token.offset = length - token.offset; };
+    tokens.moveGap(i, flip, flip);
+}
+
+void IncrementalAnalyzer::moveSummandGap(size_t k)
+{
+    size_t count = tokens.size();
+    auto flip = [count](Summand &summand) { summand.first = count - summand.first; };
+    summands.moveGap(k, flip, flip);
+}
+
+void IncrementalAnalyzer::analyzeAll()
+{
+    stats = EditStats();
+    stats.full = true;
+    summands.clear();
+    failedSummands = 0;
+    total = Polynomial();
+    compactedSize = 0;
+    tokens.clear();
+    try
+    {
+        std::string_view text(source.contiguous(), source.size());
+        TokenBuffer all = Lexer(text).tokenize();
+        for (size_t i = 0; i < all.size(); ++i)
+            tokens.insert(TokenEntry{static_cast<std::uint32_t>(all.offset(i)), static_cast<std::uint32_t>(all.length(i)),
+                                     all.type(i)});
+        lexFailed = false;
+    }
+    catch (const std::exception &)
+    {
+        tokens.clear();
+        lexFailed = true;
+        return;
+    }
+    stats.tokensLexed = tokens.size();
+    resplit(0, tokens.size(), 1);
+}
+
+void IncrementalAnalyzer::edit(size_t offset, size_t removed, std::string_view inserted)
+{
+    if (offset > source.size() || removed > source.size() - offset)
+        throw std::out_of_range("Edit range outside the text");
+    if (source.size() - removed + inserted.size() > UINT32_MAX)
+        throw std::runtime_error("Input too large");
+    auto replaceText = [&] {
+        source.moveGap(offset);
+        source.eraseAfter(removed);
+        source.insert(inserted.begin(), inserted.end());
+    };
+    if (lexFailed)
+    {
+        replaceText();
+        analyzeAll();
+        return;
+    }
+    stats = EditStats();
+
+    // 从最后一个可能读到编辑位置的 Token 重新切分
+    size_t count = tokens.size();
+    // 第一个 offset + length + 4 > offset 的 Token（EOF 一定满足）
+    size_t first = searchFrom(tokens.gap(), count,
+                              [&](size_t i) { return tokenOffset(i) + tokens[i].length + 4 <= offset; });
+    // 隐式乘号是否存在取决于它后面的 Token，一起重新生成
+    if (first > 0 && isImplicitMul(first - 1))
+        --first;
+    size_t restart = first == 0 ? 0 : tokenOffset(first - 1) + tokens[first - 1].length;
+    TokenType previous = first == 0 ? TokenType::END_OF_FILE : tokens[first - 1].type;
+
+    // 间隙移到编辑处：之前的位置不受编辑影响，之后的按到末尾的距离存放，改动文本后自动平移。
+    // 加项的间隙放在重新划分的起点之后
+    moveTokenGap(first);
+    size_t next = searchFrom(summands.gap(), summands.size(), [&](size_t k) { return summandFirst(k) <= first; });
+    size_t index = next - 1; // 包含 first 的加项
+    if (index > 0 && summandFirst(index) == first)
+        --index; // 起点的 +/- 本身被重新切分了
+    moveSummandGap(index + 1);
+    // 与编辑区域重叠的旧 Token 在平移后的位置没有意义（可能小于 0），对齐从它们之后开始找
+    size_t survivor = first;
+    while (tokenOffset(survivor) < offset + removed)
+        ++survivor;
+    replaceText();
+
+    // 新切出的 Token 越过编辑区域后，一旦与平移后的旧 Token 完全相同，后面的切分也都相同。
+    // EOF 总能对上，所以循环一定会结束。只复制 restart 之后的一段文本来切分，
+    // Token 离窗口末尾太近（可能被截断）时把窗口加倍重来
+    size_t editEnd = offset + inserted.size();
+    size_t length = source.size();
+    size_t matched = survivor;
+    try
+    {
+        for (size_t size = editEnd - restart + 64;; size *= 2)
+        {
+            size_t windowEnd = std::min(length, restart + size);
+            bool whole = windowEnd == length;
+            window.clear();
+            source.copy(restart, windowEnd, window);
+            fresh.clear();
+            matched = survivor;
+            bool truncated = false;
+            Lexer lexer(window, 0, previous);
+            for (;;)
+            {
+                Token token = lexer.next();
+                size_t pos = restart + size_t(token.value.data() - window.data());
+                if (!whole && pos + token.value.size() + kLookahead > windowEnd)
+                {
+                    truncated = true;
+                    break;
+                }
+                ++stats.tokensLexed;
+                if (pos >= editEnd && !(token.type == TokenType::MUL && token.value.empty()))
+                {
+                    while (matched < count && (tokenOffset(matched) < pos || isImplicitMul(matched)))
+                        ++matched;
+                    if (matched < count && tokenOffset(matched) == pos && tokens[matched].type == token.type &&
+                        tokens[matched].length == token.value.size())
+                        break;
+                }
+                fresh.push_back(TokenEntry{static_cast<std::uint32_t>(pos),
+                                           static_cast<std::uint32_t>(token.value.size()), token.type});
+            }
+            if (!truncated)
+                break;
+        }
+    }
+    catch (const std::exception &)
+    {
+        // 出现了无法识别的字符，之后的编辑都做完整分析，直到它被删掉
+        analyzeAll();
+        return;
+    }
+
+    // 同样，起点在被替换的 Token 中的旧加项不参与对齐
+    size_t old = index + 1;
+    while (old < summands.size() && summandFirst(old) < matched)
+        ++old;
+
+    // 用新 Token 替换 [first, matched)：它们紧跟在间隙之后
+    tokens.eraseAfter(matched - first);
+    tokens.insert(fresh.begin(), fresh.end());
+
+    // 边界的判定依赖前一个 Token，所以对齐的 Token 本身也要重新判定
+    resplit(index, first + fresh.size(), old);
+}
+
+void IncrementalAnalyzer::resplit(size_t index, size_t changedEnd, size_t old)
+{
+    // 从 summands[index] 的起点扫描，括号深度 0 处的二元 +/- 是边界；多余的 ')' 不让深度变为负数，
+    // 这样每个边界处的扫描状态都相同，可以从任意一个边界开始
+    size_t start = summands.empty() ? 0 : summandFirst(index);
+    size_t eof = tokens.size() - 1;
+    std::vector<size_t> starts{start};
+    size_t stop = eof;
+    int depth = 0;
+    for (size_t i = start; i < eof; ++i)
+    {
+        TokenType type = tokens[i].type;
+        if (type == TokenType::LPAREN)
+            ++depth;
+        else if (type == TokenType::RPAREN)
+            depth = std::max(depth - 1, 0);
+        else if (depth == 0 && i > start && isBoundary(i))
+        {
+            if (i >= changedEnd)
+            {
+                // 越过改动后遇到旧的边界，后面的加项不变
+                while (old < summands.size() && summandFirst(old) < i)
+                    ++old;
+                if (old < summands.size() && summandFirst(old) == i)
+                {
+                    stop = i;
+                    break;
+                }
+            }
+            starts.push_back(i);
+        }
+    }
+    if (stop == eof)
+        old = summands.size();
+
+    // 旧的 [index, old) 在间隙两侧：index 紧挨在间隙前，其余紧跟在间隙后
+    if (!summands.empty())
+    {
+        for (size_t k = index; k < old; ++k)
+        {
+            if (summands[k].ok)
+                total.add(summands[k].poly, -summands[k].sign);
+            else
+                --failedSummands;
+        }
+        summands.eraseAfter(old - index - 1);
+        summands.eraseBefore(1);
+    }
+
+    for (size_t k = 0; k < starts.size(); ++k)
+    {
+        Summand summand;
+        summand.first = starts[k];
+        analyze(summand, k + 1 < starts.size() ? starts[k + 1] : stop);
+        summands.insert(std::move(summand));
+    }
+    stats.summandsParsed = starts.size();
+    stats.summands = summands.size();
+
+    // 相互抵消的项在 total 中留下系数为 0 的项，积累到一定数量时整理一次（均摊 O(1)）
+    if (total.terms().size() > 2 * compactedSize + 64)
+    {
+        total.canonicalize();
+        compactedSize = total.terms().size();
+    }
+}
+
+void IncrementalAnalyzer::analyze(Summand &summand, size_t end)
+{
+    // 第一个加项没有前导的 +/-
+    size_t begin = summand.first == 0 ? 0 : summand.first + 1;
+    summand.sign = summand.first > 0 && tokens[summand.first].type == TokenType::MINUS ? -1 : 1;
+    summand.ok = false;
+
+    // 把这一段的文本和 Token 复制出来，位置改为相对于复制的文本
+    size_t textBegin = tokenOffset(std::min(begin, end));
+    size_t textEnd = end > begin ? tokenOffset(end - 1) + tokens[end - 1].length : textBegin;
+    window.clear();
+    source.copy(textBegin, textEnd, window);
+    piece.source = window;
+    piece.types.clear();
+    piece.offsets.clear();
+    piece.lengths.clear();
+    for (size_t i = begin; i < end; ++i)
+        piece.push(tokens[i].type, tokenOffset(i) - textBegin, tokens[i].length);
+    try
+    {
+        scratch.clear();
+        Parser parser(piece, 0, piece.size());
+        NodeId root = parser.parse(scratch);
+        summand.poly = EqualityChecker::standardize(scratch, root);
+        summand.ok = true;
+    }
+    catch (const std::exception &)
+    {
+        summand.poly = Polynomial();
+    }
+    if (summand.ok)
+        total.add(summand.poly, summand.sign);
+    else
+        ++failedSummands;
+}
+
+std::string IncrementalAnalyzer::error() const
+{
+    if (ok())
+        return std::string();
+    // 与完整分析的流程相同：先切分全部 Token，再解析
+    std::string all = text();
+    try
+    {
+        TokenBuffer tokens = Lexer(all).tokenize();
+        Parser(tokens).parse();
+    }
+    catch (const std::exception &err)
+    {
+        return err.what();
+    }
+    return std::string();
+}
+
+std::string IncrementalAnalyzer::canonical() const
+{
+    if (!ok())
+        throw std::runtime_error(error());
+    PolyArena arena;
+    Polynomial sorted = total;
+    sorted.canonicalize();
+    return polyToString(sorted);
+}
+
+Fingerprint IncrementalAnalyzer::fingerprint() const
+{
+    if (!ok())
+        throw std::runtime_error(error());
+    return total.fingerprint();
+}
@@ -0,0 +1,131 @@
+/**
+ * @file IncrementalAnalyzer.h
+ * @brief Declares an analyzer that keeps its state across edits of one expression.
+ *
+ * An editor that re-analyzes the expression on every keystroke would re-tokenize, re-parse
+ * and re-standardize the whole input each time. IncrementalAnalyzer keeps the text, its
+ * TokenBuffer and the top-level summands of the expression, each with its standardized
+ * polynomial, and on edit():
+ *
+ *   - re-lexes from the last token whose lexing could have looked at the edited bytes
+ *     (keywords look up to 4 characters ahead, numbers one past their end) until the new
+ *     token stream lines up with the old one again;
+ *   - re-splits the changed tokens into summands, starting at the summand boundary before
+ *     them and stopping at the first boundary after them that existed before;
+ *   - parses and standardizes only the summands in between, and updates the running sum
+ *     by subtracting their old polynomials and adding the new ones.
+ *
+ * A summand is a maximal run of tokens between binary + / - at parenthesis depth 0 (a - is
+ * binary when it follows a number, variable or ')'), so the expression is
+ * s0 ± s1 ± ... ± sn and its polynomial is the signed sum of theirs; the result equals a
+ * full analysis of the new text. Lexing, parsing and standardizing therefore cost time
+ * proportional to the edited summands.
+ *
+ * The text, the tokens and the summands are kept in gap buffers (GapBuffer.h) whose gaps
+ * follow the edits. Token offsets after the gap are stored as distances from the end of the
+ * text and summand starts after the gap as distances from the last token, so the positions
+ * after an edit shift without being rewritten. An edit costs time proportional to its own
+ * size plus its distance from the previous edit, whatever the length of the text. An edit
+ * that unbalances parentheses re-splits to the end of the text, and an edit inside one huge
+ * summand (for example deep inside x*(...)) re-parses that summand.
+ *
+ * While the text does not parse, ok() is false and the summands that do parse keep their
+ * results, so the next edit stays incremental. A character the lexer rejects makes every
+ * edit a full analysis until it is removed.
+ *
+ * Polynomials are kept on the global heap; do not call edit() inside a PolyArena scope.
+ */
+#ifndef INCREMENTAL_ANALYZER_H
+#define INCREMENTAL_ANALYZER_H
+
+#include "AstArena.h"
+#include "GapBuffer.h"
+#include "Lexer.h"
+#include "Polynomial.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class IncrementalAnalyzer
+{
+public:
+    // 最近一次 edit()（或完整分析）的工作量
+    struct EditStats
+    {
+        size_t tokensLexed = 0;    // 重新切分的 Token 数
+        size_t summandsParsed = 0; // 重新解析和标准化的加项数
+        size_t summands = 0;       // 编辑后加项的总数
+        bool full = false;         // 是否做了完整分析
+    };
+
+    explicit IncrementalAnalyzer(std::string text = std::string());
+
+    // 用 inserted 替换 [offset, offset + removed) 处的文本，范围越界时抛出 std::out_of_range
+    void edit(size_t offset, size_t removed, std::string_view inserted);
+    // 换成全新的文本并完整分析
+    void reset(std::string text);
+
+    // 当前文本（拼接成新的字符串，与文本长度成正比）
+    std::string text() const;
+    // 当前文本能否解析；不能时 error() 给出与完整解析相同的错误信息（为此完整解析一次）
+    bool ok() const { return !lexFailed && failedSummands == 0; }
+    std::string error() const;
+    // 规范形式，与 EqualityChecker::getStandardizedString 相同；需要排序全部项，
+    // 因此与表达式的大小成正比。不能解析时抛出 std::runtime_error
+    std::string canonical() const;
+    // 规范形式的指纹，随每次编辑增量维护，O(1)。不能解析时抛出 std::runtime_error
+    Fingerprint fingerprint() const;
+
+    const EditStats &lastEdit() const { return stats; }
+
+private:
+    struct Summand
+    {
+        size_t first = 0; // 第一个 Token 的下标，除第一个加项外是前面的 + 或 -；间隙后存到最后一个 Token 的距离
+        int sign = 1;
+        bool ok = false;
+        Polynomial poly; // 不含符号，解析失败时为空
+    };
+
+    struct TokenEntry
+    {
+        std::uint32_t offset = 0; // 间隙前是文本中的位置，间隙后是到文本末尾的距离
+        std::uint32_t length = 0;
+        TokenType type = TokenType::END_OF_FILE;
+    };
+
+    GapBuffer<char> source;
+    GapBuffer<TokenEntry> tokens; // 末尾是 EOF
+    bool lexFailed = false;
+
+    GapBuffer<Summand> summands;
+    size_t failedSummands = 0;
+    Polynomial total;         // 各加项带符号之和，不排序
+    size_t compactedSize = 0; // 上次整理 total 时的项数
+
+    AstArena scratch;       // 解析加项用，复用容量
+    std::string window;     // 重新切分或解析的一段文本的副本
+    TokenBuffer piece;      // 一个加项的 Token，位置相对于 window
+    std::vector<TokenEntry> fresh;
+    EditStats stats;
+
+    size_t tokenOffset(size_t i) const;
+    size_t summandFirst(size_t k) const;
+    bool isImplicitMul(size_t i) const;
+    bool isBoundary(size_t i) const;
+    // 把间隙移到第 i 个 Token / 第 k 个加项前，越过间隙的位置在两种表示之间换算
+    void moveTokenGap(size_t i);
+    void moveSummandGap(size_t k);
+
+    void analyzeAll();
+    // 从 summands[index] 的起点重新划分加项，直到越过 Token 下标 changedEnd 后对齐到 summands[old]
+    // 或它之后的旧边界（间隙后的旧加项已经按新的 Token 下标平移）。
+    // 加项的间隙必须在 index + 1 处（没有加项时为 0）
+    void resplit(size_t index, size_t changedEnd, size_t old);
+    // 解析并标准化 [summand.first, end) 的 Token，计入 total
+    void analyze(Summand &summand, size_t end);
+};
+
+#endif // INCREMENTAL_ANALYZER_H
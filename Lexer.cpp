@@ -3,22 +3,30 @@
  * @brief Implements the core logic of the Lexical Analyzer.
  *
  * This file details the procedures for character consumption, skipping whitespace, and
- * identifying the different token types (ScanNumber, ScanIdentifier). Crucially, it
- * implements the Consume method, which is the primary interface for the Parser.
- * The Consume method is where the logic for inserting the STAR (*) token for
- * implicit multiplication (e.g., in '3x' or '2(x+1)') is handled.
+ * identifying the different token types (ScanNumber, ScanIdentifier). Tokens are written
+ * into a TokenBuffer as (type, offset, length) triples, or pulled one at a time through
+ * next(). The MUL token for implicit multiplication (e.g., in '3x' or '2(x+1)') is
+ * inserted by next() using a single token of lookahead.
  */
 #include "Lexer.h"
+#include "PerfStats.h"
 #include <cctype>
 #include <stdexcept>
-#include <algorithm> // for std::find if needed
+#include <utility>
 
-Lexer::Lexer(const std::string &text) : text(text), pos(0)
+Lexer::Lexer(std::string_view text)
+    : text(text), pos(0), prev_type(TokenType::END_OF_FILE), has_pending(false)
 {
     current_char = text.empty() ? '\0' : text[0];
     length = text.length();
 }
 
+Lexer::Lexer(std::string_view text, size_t start, TokenType previous)
+    : text(text), pos(start), length(text.length()), prev_type(previous), has_pending(false)
+{
+    current_char = pos < length ? text[pos] : '\0';
+}
+
 // pos+1 & read next char
 void Lexer::advance()
 {
@@ -43,20 +51,19 @@ void Lexer::skip_whitespace()
 
 Token Lexer::number()
 {
-    std::string result;
+    size_t start = pos;
     while (current_char != '\0' && std::isdigit(current_char))
     {
-        result += current_char;
         advance();
     }
-    return {TokenType::INT, result};
+    return {TokenType::INT, text.substr(start, pos - start)};
 }
 
 // 优先检查是否是函数关键字，如果是则消耗整个关键字；否则只消耗一个字符作为变量
-void Lexer::identifier(std::vector<Token> &tokens)
+Token Lexer::identifier()
 {
     // define keywords
-    static const std::vector<std::pair<std::string, TokenType>> keywords = {
+    static constexpr std::pair<std::string_view, TokenType> keywords[] = {
         {"sin", TokenType::SIN},
         {"cos", TokenType::COS},
         {"tan", TokenType::TAN},
@@ -64,146 +71,156 @@ void Lexer::identifier(std::vector<Token> &tokens)
         {"ln", TokenType::LN},
         {"sqrt", TokenType::SQRT}};
 
+    size_t start = pos;
+
     // check whether match keywords
     for (const auto &kw : keywords)
     {
-        const std::string &name = kw.first;
+        std::string_view name = kw.first;
         size_t len = name.length();
 
         // 边界检查：剩余长度是否足够
-        if (pos + len <= length)
+        if (pos + len <= length && text.compare(pos, len, name) == 0)
         {
-            bool match = true;
             for (size_t i = 0; i < len; ++i)
             {
-                if (text[pos + i] != name[i])
-                {
-                    match = false;
-                    break;
-                }
-            }
-
-            if (match)
-            {
-                tokens.push_back(Token(kw.second, name));
-
-                for (size_t i = 0; i < len; ++i)
-                {
-                    advance();
-                }
-                return;
+                advance();
             }
+            return {kw.second, text.substr(start, len)};
         }
     }
 
     // 若所有关键字都没匹配上，那当前字符就是一个变量
-    std::string varName(1, current_char);
-    tokens.push_back(Token(TokenType::VAR, varName));
     advance();
+    return {TokenType::VAR, text.substr(start, 1)};
 }
 
-std::vector<Token> Lexer::tokenize()
+Token Lexer::scan()
 {
-    std::vector<Token> tokens;
+    skip_whitespace();
 
-    while (current_char != '\0')
+    if (current_char == '\0')
     {
-        // blank space
-        if (std::isspace(current_char))
-        {
-            skip_whitespace();
-            continue;
-        }
+        return {TokenType::END_OF_FILE, text.substr(length, 0)};
+    }
 
-        // number
-        if (std::isdigit(current_char))
-        {
-            tokens.push_back(number());
-            continue;
-        }
+    // number
+    if (std::isdigit(current_char))
+    {
+        return number();
+    }
 
-        // character
-        if (std::isalpha(current_char))
-        {
-            identifier(tokens);
-            continue;
-        }
+    // character
+    if (std::isalpha(current_char))
+    {
+        return identifier();
+    }
 
-        // operators
-        switch (current_char)
-        {
-        case '+':
-            tokens.push_back({TokenType::PLUS, "+"});
-            break;
-        case '-':
-            tokens.push_back({TokenType::MINUS, "-"});
-            break;
-        case '*':
-            tokens.push_back({TokenType::MUL, "*"});
-            break;
-        case '/':
-            tokens.push_back({TokenType::DIV, "/"});
-            break;
-        case '^':
-            tokens.push_back({TokenType::POW, "^"});
-            break;
-        case '(':
-            tokens.push_back({TokenType::LPAREN, "("});
-            break;
-        case ')':
-            tokens.push_back({TokenType::RPAREN, ")"});
-            break;
-        default:
-            // throw error
-            throw std::runtime_error(std::string("Unknown character: ") + current_char);
-        }
+    // operators
+    TokenType type;
+    switch (current_char)
+    {
+    case '+':
+        type = TokenType::PLUS;
+        break;
+    case '-':
+        type = TokenType::MINUS;
+        break;
+    case '*':
+        type = TokenType::MUL;
+        break;
+    case '/':
+        type = TokenType::DIV;
+        break;
+    case '^':
+        type = TokenType::POW;
+        break;
+    case '(':
+        type = TokenType::LPAREN;
+        break;
+    case ')':
+        type = TokenType::RPAREN;
+        break;
+    default:
+        // throw error
+        throw std::runtime_error(std::string("Unknown character: ") + current_char);
+    }
+    Token token(type, text.substr(pos, 1));
+    advance();
+    return token;
+}
 
-        advance();
+Token Lexer::next()
+{
+    if (has_pending)
+    {
+        has_pending = false;
+        prev_type = pending.type;
+        return pending;
     }
 
-    tokens.push_back({TokenType::END_OF_FILE, ""});
+    Token curr = scan();
+
+    // 判断前一个 Token 是否是可能触发隐式乘法的“左值”
+    bool is_prev_valid = (prev_type == TokenType::INT ||
+                          prev_type == TokenType::VAR ||
+                          prev_type == TokenType::RPAREN);
+
+    // 判断当前 Token 是否是可能触发隐式乘法的“右值”
+    bool is_curr_valid = (curr.type == TokenType::VAR ||
+                          curr.type == TokenType::INT ||
+                          curr.type == TokenType::LPAREN ||
+                          curr.type == TokenType::SIN ||
+                          curr.type == TokenType::COS ||
+                          curr.type == TokenType::TAN ||
+                          curr.type == TokenType::COT ||
+                          curr.type == TokenType::LN ||
+                          curr.type == TokenType::SQRT);
+
+    if (is_prev_valid && is_curr_valid)
+    {
+        // 先返回隐式乘号（没有对应的源文本，长度为 0），curr 留到下一次
+        pending = curr;
+        has_pending = true;
+        prev_type = TokenType::MUL;
+        return {TokenType::MUL, curr.value.substr(0, 0)};
+    }
 
-    // handle implicit mult
-    return handle_implicit_multiplication(tokens);
+    prev_type = curr.type;
+    return curr;
 }
 
-std::vector<Token> Lexer::handle_implicit_multiplication(const std::vector<Token> &input_tokens)
+TokenBuffer Lexer::tokenize()
 {
-    std::vector<Token> result;
-    if (input_tokens.empty())
-        return result;
-
-    result.push_back(input_tokens[0]);
-
-    for (size_t i = 1; i < input_tokens.size(); ++i)
+    PerfStats::Timer timer(Phase::Tokenize);
+    if (length > UINT32_MAX)
     {
-        Token prev = input_tokens[i - 1];
-        Token curr = input_tokens[i];
-
-        bool needs_mult = false;
-
-        // 判断前一个 Token 是否是可能触发隐式乘法的“左值”
-        bool is_prev_valid = (prev.type == TokenType::INT ||
-                              prev.type == TokenType::VAR ||
-                              prev.type == TokenType::RPAREN);
-
-        // 判断当前 Token 是否是可能触发隐式乘法的“右值”
-        bool is_curr_valid = (curr.type == TokenType::VAR ||
-                              curr.type == TokenType::INT ||
-                              curr.type == TokenType::LPAREN ||
-                              curr.type == TokenType::SIN ||
-                              curr.type == TokenType::COS ||
-                              curr.type == TokenType::TAN ||
-                              curr.type == TokenType::COT ||
-                              curr.type == TokenType::LN ||
-                              curr.type == TokenType::SQRT);
-
-        if (is_prev_valid && is_curr_valid)
-        {
-            result.push_back({TokenType::MUL, "*"});
-        }
+        throw std::runtime_error("Input too large");
+    }
 
-        result.push_back(curr);
+    TokenBuffer tokens;
+    tokens.source = text;
+    // 按每两个字符一个 Token 估计容量，不按字符数预留（那样每个输入字节要先占约 9 字节）；
+    // 超出时按倍数扩容，分配次数仍是 O(log(Token 数))
+    size_t estimate = length / 2 + 16;
+    tokens.types.reserve(estimate);
+    tokens.offsets.reserve(estimate);
+    tokens.lengths.reserve(estimate);
+
+    Token token;
+    do
+    {
+        token = next();
+        tokens.push(token.type, token.value.data() - text.data(), token.value.size());
+    } while (token.type != TokenType::END_OF_FILE);
+    // 扩容后可能空出近一半容量，输入很大时归还多余部分
+    if (tokens.types.capacity() - tokens.size() > tokens.size() / 4 + 1024)
+    {
+        tokens.types.shrink_to_fit();
+        tokens.offsets.shrink_to_fit();
+        tokens.lengths.shrink_to_fit();
     }
-    return result;
-}
\ No newline at end of file
+
+    PerfStats::addTokens(tokens.size());
+    return tokens;
+}
@@ -5,18 +5,21 @@
  * The Lexer is responsible for transforming the raw input string into a stream of Tokens.
  * This class includes methods for advancing through the input stream and recognizing tokens
  * like numbers, variables, operators, and reserved function names (e.g., sin, ln).
- * It also defines the lookahead mechanism (current_token and next_token) necessary for
- * robust handling of implicit multiplication, which is implemented in Lexer.cpp.
+ * Tokens are stored in a TokenBuffer (parallel arrays of types and source offsets/lengths)
+ * so that tokenizing never allocates per token; implicit multiplication is handled while
+ * scanning, in Lexer.cpp.
  */
 #ifndef LEXER_H
 #define LEXER_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <iostream>
 
 // 定义“词法单元类型”
-enum class TokenType
+enum class TokenType : std::uint8_t
 {
     // 数据类
     INT, // 整数 
@@ -43,11 +46,12 @@ enum class TokenType
     END_OF_FILE // 结束标记
 };
 
+// Token 只是源文本的一个视图，不持有内存，拷贝代价很小
 struct Token
 {
-    TokenType type;
-    std::string value; // 存储具体的字符
-    Token(TokenType t, std::string v) : type(t), value(v) {}
+    TokenType type = TokenType::END_OF_FILE;
+    std::string_view value; // 指向源文本中的具体字符（隐式乘号为空）
+    Token(TokenType t, std::string_view v) : type(t), value(v) {}
     Token() {}
     // 方便调试打印
     std::string toString() const
@@ -55,9 +59,9 @@ struct Token
         switch (type)
         {
         case TokenType::INT:
-            return "INT(" + value + ")";
+            return "INT(" + std::string(value) + ")";
         case TokenType::VAR:
-            return "VAR(" + value + ")";
+            return "VAR(" + std::string(value) + ")";
         case TokenType::PLUS:
             return "PLUS";
         case TokenType::MUL:
@@ -87,28 +91,70 @@ struct Token
         case TokenType::SQRT:
             return "SQRT";
         default:
-            return "TOKEN(" + value + ")";
+            return "TOKEN(" + std::string(value) + ")";
         }
     }
 };
 
+// 结构数组 (SoA) 形式的 Token 序列：类型、源文本偏移、长度分别存放在三个数组中，
+// Token 本身不做任何堆分配，文本通过偏移从源字符串中取得
+class TokenBuffer
+{
+public:
+    size_t size() const { return types.size(); }
+    TokenType type(size_t i) const { return types[i]; }
+    std::string_view text(size_t i) const { return source.substr(offsets[i], lengths[i]); }
+    Token operator[](size_t i) const { return Token(types[i], text(i)); }
+    // Token 在源文本中的位置；隐式乘号的长度为 0，位置是它后面那个 Token 的位置
+    size_t offset(size_t i) const { return offsets[i]; }
+    size_t length(size_t i) const { return lengths[i]; }
+
+private:
+    friend class Lexer;
+    friend class IncrementalAnalyzer;
+
+    std::string_view source;
+    std::vector<TokenType> types;
+    std::vector<std::uint32_t> offsets;
+    std::vector<std::uint32_t> lengths;
+
+    void push(TokenType type, size_t offset, size_t length)
+    {
+        types.push_back(type);
+        offsets.push_back(static_cast<std::uint32_t>(offset));
+        lengths.push_back(static_cast<std::uint32_t>(length));
+    }
+};
+
+// Lexer 与它产生的 TokenBuffer 只引用输入文本，调用者需保证文本在使用期间有效
 class Lexer
 {
 public:
-    explicit Lexer(const std::string &text);
-    std::vector<Token> tokenize();
+    explicit Lexer(std::string_view text);
+    // 从 start 处继续切分，previous 为前一个 Token 的类型（决定是否插入隐式乘号），
+    // 用于只重新切分编辑过的一段文本
+    Lexer(std::string_view text, size_t start, TokenType previous);
+    // 一次性切分出完整的 Token 序列
+    TokenBuffer tokenize();
+    // 流式接口：按需返回下一个 Token（已处理隐式乘法），到达末尾后一直返回 EOF
+    Token next();
 
 private:
-    std::string text;
+    std::string_view text;
     size_t pos;
     size_t length; // 字符串长度
     char current_char;
 
+    // 隐式乘法只需要一个 Token 的前瞻
+    TokenType prev_type;
+    bool has_pending;
+    Token pending;
+
     void advance();
     void skip_whitespace();
+    Token scan(); // 读取下一个原始 Token（不含隐式乘号）
     Token number();
-    void identifier(std::vector<Token> &tokens); // 处理变量和函数
-    std::vector<Token> handle_implicit_multiplication(const std::vector<Token> &tokens);
+    Token identifier(); // 处理变量和函数
 };
 
 #endif
\ No newline at end of file
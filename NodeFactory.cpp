@@ -0,0 +1,63 @@
+/**
+ * @file NodeFactory.cpp
+ * @brief Implements hash-consed node construction.
+ */
+#include "NodeFactory.h"
+
+template <typename Make>
+std::shared_ptr<ASTNode> NodeFactory::intern(Key key, Make &&make)
+{
+    auto it = nodes.find(key);
+    if (it != nodes.end())
+    {
+        return it->second;
+    }
+    std::shared_ptr<ASTNode> node = make();
+    // 节点由表项持有，键中的文本可以安全地指向它
+    if (node->kind == NodeKind::Number)
+        key.text = static_cast<const NumberNode &>(*node).value;
+    else if (node->kind == NodeKind::Variable)
+        key.text = static_cast<const VariableNode &>(*node).name;
+    nodes.emplace(key, node);
+    return node;
+}
+
+std::shared_ptr<ASTNode> NodeFactory::number(std::string_view value)
+{
+    return intern(Key{NodeKind::Number, TokenType::INT, nullptr, nullptr, value,
+                      leafHash(NodeKind::Number, value)},
+                  [&]
+                  { return std::make_shared<NumberNode>(value); });
+}
+
+std::shared_ptr<ASTNode> NodeFactory::variable(std::string_view name)
+{
+    return intern(Key{NodeKind::Variable, TokenType::VAR, nullptr, nullptr, name,
+                      leafHash(NodeKind::Variable, name)},
+                  [&]
+                  { return std::make_shared<VariableNode>(name); });
+}
+
+std::shared_ptr<ASTNode> NodeFactory::unary(TokenType op, std::shared_ptr<ASTNode> operand)
+{
+    return intern(Key{NodeKind::UnaryOp, op, nullptr, operand.get(), {},
+                      opHash(NodeKind::UnaryOp, op, 0, operand->hash)},
+                  [&]
+                  { return std::make_shared<UnaryOpNode>(op, std::move(operand)); });
+}
+
+std::shared_ptr<ASTNode> NodeFactory::binary(TokenType op, std::shared_ptr<ASTNode> left, std::shared_ptr<ASTNode> right)
+{
+    return intern(Key{NodeKind::BinaryOp, op, left.get(), right.get(), {},
+                      opHash(NodeKind::BinaryOp, op, left->hash, right->hash)},
+                  [&]
+                  { return std::make_shared<BinaryOpNode>(op, std::move(left), std::move(right)); });
+}
+
+std::shared_ptr<ASTNode> NodeFactory::function(TokenType funcType, std::shared_ptr<ASTNode> arg)
+{
+    return intern(Key{NodeKind::Function, funcType, nullptr, arg.get(), {},
+                      opHash(NodeKind::Function, funcType, 0, arg->hash)},
+                  [&]
+                  { return std::make_shared<FunctionNode>(funcType, std::move(arg)); });
+}
@@ -0,0 +1,62 @@
+/**
+ * @file NodeFactory.h
+ * @brief Declares a hash-consing factory for shared_ptr AST nodes.
+ *
+ * Nodes created through the same NodeFactory are unique per structure: building a node
+ * whose kind, operator, text and children match an existing one returns the existing node.
+ * Repeated subterms (e.g. sin(xx) appearing several times) therefore become one shared
+ * node, and two subtrees from the same factory are structurally identical exactly when
+ * they are the same pointer. The factory keeps every node it created alive until clear()
+ * or destruction, so it can be reused across parses as a session-wide cache.
+ */
+#ifndef NODEFACTORY_H
+#define NODEFACTORY_H
+
+#include "AST.h"
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+
+class NodeFactory
+{
+public:
+    std::shared_ptr<ASTNode> number(std::string_view value);
+    std::shared_ptr<ASTNode> variable(std::string_view name);
+    std::shared_ptr<ASTNode> unary(TokenType op, std::shared_ptr<ASTNode> operand);
+    std::shared_ptr<ASTNode> binary(TokenType op, std::shared_ptr<ASTNode> left, std::shared_ptr<ASTNode> right);
+    std::shared_ptr<ASTNode> function(TokenType funcType, std::shared_ptr<ASTNode> arg);
+
+    // 当前共享的不同节点数
+    size_t size() const { return nodes.size(); }
+    void clear() { nodes.clear(); }
+
+private:
+    // 子节点已经是唯一的，因此比较子节点地址即可判断结构是否相同。
+    // text 在查找时指向调用者的文本，插入时改为指向新节点自己保存的文本，查找不分配内存
+    struct Key
+    {
+        NodeKind kind;
+        TokenType op;
+        const ASTNode *left;
+        const ASTNode *right;
+        std::string_view text;
+        std::size_t hash;
+
+        bool operator==(const Key &other) const
+        {
+            return kind == other.kind && op == other.op && left == other.left &&
+                   right == other.right && text == other.text;
+        }
+    };
+    struct KeyHash
+    {
+        std::size_t operator()(const Key &key) const { return key.hash; }
+    };
+
+    std::unordered_map<Key, std::shared_ptr<ASTNode>, KeyHash> nodes;
+
+    template <typename Make>
+    std::shared_ptr<ASTNode> intern(Key key, Make &&make);
+};
+
+#endif
@@ -1,27 +1,124 @@
 /**
  * @file Parser.cpp
- * @brief Implements the recursive descent parser.
+ * @brief Implements the operator-precedence parser.
  */
 #include "Parser.h"
+#include "PerfStats.h"
+#include <algorithm>
 #include <stdexcept>
 
-Parser::Parser(const std::vector<Token>& tokens) : tokens(tokens), pos(0) {
-    if (!tokens.empty()) {
-        current_token = tokens[0];
-    } else {
-        current_token = Token(TokenType::END_OF_FILE, "");
+namespace {
+
+// 构造 shared_ptr 节点树
+struct SharedTreeBuilder {
+    using Ref = std::shared_ptr<ASTNode>;
+    size_t count = 0; // 构造的节点数
+
+    Ref number(std::string_view value) { ++count; return std::make_shared<NumberNode>(value); }
+    Ref variable(std::string_view name) { ++count; return std::make_shared<VariableNode>(name); }
+    Ref unary(TokenType op, Ref operand) { ++count; return std::make_shared<UnaryOpNode>(op, std::move(operand)); }
+    Ref binary(TokenType op, Ref left, Ref right) {
+        ++count;
+        return std::make_shared<BinaryOpNode>(op, std::move(left), std::move(right));
+    }
+    Ref function(TokenType type, Ref arg) { ++count; return std::make_shared<FunctionNode>(type, std::move(arg)); }
+};
+
+// 把节点追加到 AstArena 中
+struct ArenaBuilder {
+    using Ref = NodeId;
+    AstArena& arena;
+
+    Ref number(std::string_view value) { return arena.addNumber(value); }
+    Ref variable(std::string_view name) { return arena.addVariable(name); }
+    Ref unary(TokenType op, Ref operand) { return arena.addUnary(op, operand); }
+    Ref binary(TokenType op, Ref left, Ref right) { return arena.addBinary(op, left, right); }
+    Ref function(TokenType type, Ref arg) { return arena.addFunction(type, arg); }
+};
+
+// 通过 NodeFactory 构造，重复的子树复用已有节点
+struct FactoryBuilder {
+    using Ref = std::shared_ptr<ASTNode>;
+    NodeFactory& factory;
+    size_t count = 0; // 请求的节点数（含复用的）
+
+    Ref number(std::string_view value) { ++count; return factory.number(value); }
+    Ref variable(std::string_view name) { ++count; return factory.variable(name); }
+    Ref unary(TokenType op, Ref operand) { ++count; return factory.unary(op, std::move(operand)); }
+    Ref binary(TokenType op, Ref left, Ref right) {
+        ++count;
+        return factory.binary(op, std::move(left), std::move(right));
+    }
+    Ref function(TokenType type, Ref arg) { ++count; return factory.function(type, std::move(arg)); }
+};
+
+// 运算符栈中尚未归约的元素
+// Bottom 是栈底的哨兵；左括号的优先级为 0、哨兵为 -1，归约自然会停在它们上面
+enum class PendingKind : std::uint8_t { Binary, Negate, Function, Paren, Bottom };
+
+struct PendingOp {
+    PendingKind kind;
+    TokenType op;
+    int prec;
+};
+
+// 解析用的栈，存储取自 ScratchVector：每个线程复用同一块缓冲区，预热后解析时不再为栈分配内存；
+// 析构时由 ScratchVector 清空，抛出异常时栈中剩下的子树也随之释放
+template <typename T>
+class ScratchStack {
+public:
+    T& back() { return scratch.items.back(); }
+    T& below() { return scratch.items.end()[-2]; } // 栈顶下面的一个
+    void push(T value) { scratch.items.push_back(std::move(value)); }
+    // 弹出前调用方已把 back() 移走
+    void pop() { scratch.items.pop_back(); }
+
+private:
+    ScratchVector<T> scratch;
+};
+
+// 取负和函数的优先级：比 * / 高，比 ^ 低（-x^2 = -(x^2)，-x*y = (-x)*y）
+constexpr int kPrefixPrecedence = 3;
+
+// 二元运算符的优先级，不是二元运算符时返回 0
+int binaryPrecedence(TokenType type) {
+    switch (type) {
+        case TokenType::PLUS:
+        case TokenType::MINUS:
+            return 1;
+        case TokenType::MUL:
+        case TokenType::DIV:
+            return 2;
+        case TokenType::POW:
+            return 4;
+        default:
+            return 0;
     }
 }
 
-void Parser::advance() {
-    pos++;
-    if (pos < tokens.size()) {
-        current_token = tokens[pos];
+} // namespace
+
+Parser::Parser(const TokenBuffer& tokens) : Parser(tokens, 0, tokens.size()) {}
+
+Parser::Parser(const TokenBuffer& tokens, size_t begin, size_t end)
+    : tokens(&tokens), lexer(nullptr), pos(begin), end(end) {
+    if (begin < end) {
+        current_token = tokens[begin];
     } else {
         current_token = Token(TokenType::END_OF_FILE, "");
     }
 }
 
+Parser::Parser(Lexer& lexer) : tokens(nullptr), lexer(&lexer), pos(0), end(0) {
+    current_token = lexer.next();
+}
+
+void Parser::recordStats(size_t nodes) const {
+    PerfStats::addAstNodes(nodes);
+    // 预先生成的 Token 已在 tokenize() 中计数；流式模式在这里计数（含 EOF）
+    if (lexer) PerfStats::addTokens(pos + 1);
+}
+
 void Parser::eat(TokenType type) {
     if (current_token.type == type) {
         advance();
@@ -32,106 +129,134 @@ void Parser::eat(TokenType type) {
 }
 
 std::shared_ptr<ASTNode> Parser::parse() {
-    auto node = parse_expression();
+    PerfStats::Timer timer(Phase::Parse);
+    SharedTreeBuilder builder;
+    auto node = parse_expression(builder);
     
     // 检查是否有多余的 Token
     if (current_token.type != TokenType::END_OF_FILE) {
         throw std::runtime_error("Unexpected token at end of expression: " + current_token.toString());
     }
     
+    recordStats(builder.count);
     return node;
 }
 
-// Expression: Term ((PLUS | MINUS) Term)*
-std::shared_ptr<ASTNode> Parser::parse_expression() {
-    auto left = parse_term();
-
-    while (current_token.type == TokenType::PLUS || 
-           current_token.type == TokenType::MINUS) {
-        TokenType op = current_token.type;
-        advance();
-        auto right = parse_term();
-        left = std::make_shared<BinaryOpNode>(op, std::move(left), std::move(right));
+NodeId Parser::parse(AstArena& arena) {
+    PerfStats::Timer timer(Phase::Parse);
+    size_t before = arena.size();
+    // 每个 Token 至多产生一个节点（流式模式下 Token 数未知，不预留）
+    if (tokens) {
+        arena.reserve(arena.size() + (end - pos), 0);
     }
+    ArenaBuilder builder{arena};
+    NodeId node = parse_expression(builder);
 
-    return left;
-}
-
-// Term: Factor ((MUL | DIV) Factor)*
-std::shared_ptr<ASTNode> Parser::parse_term() {
-    auto left = parse_factor();
-
-    while (current_token.type == TokenType::MUL || 
-           current_token.type == TokenType::DIV) {
-        TokenType op = current_token.type;
-        advance();
-        auto right = parse_factor();
-        left = std::make_shared<BinaryOpNode>(op, std::move(left), std::move(right));
+    if (current_token.type != TokenType::END_OF_FILE) {
+        throw std::runtime_error("Unexpected token at end of expression: " + current_token.toString());
     }
 
-    return left;
+    recordStats(arena.size() - before);
+    return node;
 }
 
-// Factor: Primary (^ Factor)? 
-// 注意：幂运算通常是右结合的，例如 2^3^4 = 2^(3^4)
-std::shared_ptr<ASTNode> Parser::parse_factor() {
-    if (current_token.type == TokenType::MINUS) {
-        TokenType op = current_token.type;
-        advance();
-    
-        auto right = parse_factor(); 
+std::shared_ptr<ASTNode> Parser::parse(NodeFactory& factory) {
+    PerfStats::Timer timer(Phase::Parse);
+    FactoryBuilder builder{factory};
+    auto node = parse_expression(builder);
 
-        return std::make_shared<UnaryOpNode>(op, std::move(right));
-    }
-    auto left = parse_primary();
-    if (current_token.type == TokenType::POW) {
-        TokenType op = current_token.type;
-        advance();
-        auto right = parse_factor(); // 递归调用自身以实现右结合
-        return std::make_shared<BinaryOpNode>(op, std::move(left), std::move(right));
+    if (current_token.type != TokenType::END_OF_FILE) {
+        throw std::runtime_error("Unexpected token at end of expression: " + current_token.toString());
     }
 
-    return left;
+    recordStats(builder.count);
+    return node;
 }
 
-// Primary: INT | VAR | LPAREN Expr RPAREN | Function
-std::shared_ptr<ASTNode> Parser::parse_primary() {
-    switch (current_token.type) {
-        case TokenType::INT: {
-            std::string val = current_token.value;
-            advance();
-            return std::make_shared<NumberNode>(val);
-        }
-        case TokenType::VAR: {
-            std::string val = current_token.value;
-            advance();
-            return std::make_shared<VariableNode>(val);
-        }
-        case TokenType::LPAREN: {
-            advance(); // eat '('
-            auto node = parse_expression();
-            eat(TokenType::RPAREN); // eat ')'
-            return node;
+// 文法（优先级从低到高）：
+//   Expression: Term ((PLUS | MINUS) Term)*
+//   Term:       Factor ((MUL | DIV) Factor)*
+//   Factor:     MINUS Factor | Function Factor | Primary (POW Factor)?    幂运算右结合：2^3^4 = 2^(3^4)
+//   Primary:    INT | VAR | LPAREN Expression RPAREN
+// 用显式的运算符栈和操作数栈实现（shunting-yard），括号和前缀运算符的嵌套深度不占用调用栈。
+// 节点按后序构造，与递归下降的构造顺序相同；出错时抛出的信息也与递归下降一致
+template <typename Builder>
+typename Builder::Ref Parser::parse_expression(Builder& builder) {
+    ScratchStack<typename Builder::Ref> operands;
+    ScratchStack<PendingOp> ops;
+    ops.push({PendingKind::Bottom, TokenType::END_OF_FILE, -1});
+
+    for (;;) {
+        // 期待操作数：前缀运算符和左括号入栈，直到读到 INT 或 VAR
+        for (bool done = false; !done;) {
+            switch (current_token.type) {
+                case TokenType::INT:
+                    operands.push(builder.number(current_token.value));
+                    advance();
+                    done = true;
+                    break;
+                case TokenType::VAR:
+                    operands.push(builder.variable(current_token.value));
+                    advance();
+                    done = true;
+                    break;
+                case TokenType::MINUS:
+                    ops.push({PendingKind::Negate, TokenType::MINUS, kPrefixPrecedence});
+                    advance();
+                    break;
+                case TokenType::LPAREN:
+                    ops.push({PendingKind::Paren, TokenType::LPAREN, 0});
+                    advance();
+                    break;
+                // 函数 sin, cos, tan, cot, ln, sqrt 作用于紧随其后的因子，所以 sin x^2 = sin(x^2)
+                case TokenType::SIN:
+                case TokenType::COS:
+                case TokenType::TAN:
+                case TokenType::COT:
+                case TokenType::LN:
+                case TokenType::SQRT:
+                    ops.push({PendingKind::Function, current_token.type, kPrefixPrecedence});
+                    advance();
+                    break;
+                default:
+                    throw std::runtime_error("Unexpected token in primary: " + current_token.toString());
+            }
         }
-        // 处理函数: sin, cos, tan, cot, ln, sqrt
-        case TokenType::SIN:
-        case TokenType::COS:
-        case TokenType::TAN:
-        case TokenType::COT:
-        case TokenType::LN:
-        case TokenType::SQRT: {
+
+        // 期待二元运算符或右括号
+        for (;;) {
             TokenType type = current_token.type;
-            advance(); // 吃掉函数名
-            
-            // 检查函数后是否有括号，虽然通常是 sin(x)，但有时数学上 sin x 也合法
-            // 这里的实现假定函数作用于紧随其后的 Primary 单元
-            // 如果是 sin(x)，parse_primary 会处理括号部分
-            auto arg = parse_factor(); // 使用 factor 以支持 sin(x)^2 这种结合 (但通常 sin x ^ 2 意味着 sin(x^2) 或 (sin x)^2 取决于约定，这里让它绑定紧随的因子)
-            // 为了安全，更建议函数必须带括号，但为了通用性，这里直接递归解析下一个因子
-            
-            return std::make_shared<FunctionNode>(type, std::move(arg));
+            int prec = binaryPrecedence(type);
+            // 先归约栈顶优先级高于 floor 的运算符：左结合的运算符连同级的一起归约，右结合的 ^ 不归约同级的；
+            // 其他 Token 结束当前的括号层，归约到左括号或栈底为止
+            int floor = prec == 0 ? 0 : (type == TokenType::POW ? prec : prec - 1);
+            while (ops.back().prec > floor) {
+                PendingOp top = ops.back();
+                ops.pop();
+                // 直接在栈上原地替换，不经过临时变量
+                auto& operand = operands.back();
+                if (top.kind == PendingKind::Binary) {
+                    auto& left = operands.below();
+                    left = builder.binary(top.op, std::move(left), std::move(operand));
+                    operands.pop();
+                } else if (top.kind == PendingKind::Negate) {
+                    operand = builder.unary(top.op, std::move(operand));
+                } else {
+                    operand = builder.function(top.op, std::move(operand));
+                }
+            }
+            if (prec > 0) {
+                ops.push({PendingKind::Binary, type, prec});
+                advance();
+                break;
+            }
+            if (ops.back().kind == PendingKind::Bottom) {
+                // 表达式结束，多余的 Token 由调用方报错
+                return std::move(operands.back());
+            }
+            // 栈顶是未闭合的左括号
+            eat(TokenType::RPAREN);
+            ops.pop();
         }
-        default:
-            throw std::runtime_error("Unexpected token in primary: " + current_token.toString());
     }
-}
\ No newline at end of file
+}
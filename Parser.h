@@ -1,34 +1,58 @@
 /**
  * @file Parser.h
- * @brief Declares the Parser class for recursive descent parsing.
+ * @brief Declares the Parser class for operator-precedence parsing.
+ *
+ * The grammar is the one in the README (+ - < * / < prefix minus and functions < right-
+ * associative ^). Parsing keeps pending operators and operands on explicit stacks, so
+ * nesting depth (parentheses, -----x, x^x^...^x) costs heap memory, not native stack.
  */
 #ifndef PARSER_H
 #define PARSER_H
 
 #include "Lexer.h"
 #include "AST.h"
+#include "AstArena.h"
+#include "NodeFactory.h"
 #include <vector>
 #include <memory>
 
 class Parser
 {
 public:
-    explicit Parser(const std::vector<Token> &tokens);
+    explicit Parser(const TokenBuffer &tokens);
+    // 只解析 tokens 中的 [begin, end)，之后视为 EOF
+    Parser(const TokenBuffer &tokens, size_t begin, size_t end);
+    // 流式模式：按需从 Lexer 拉取 Token，不生成完整的 Token 序列
+    explicit Parser(Lexer &lexer);
     std::shared_ptr<ASTNode> parse();
+    // 将节点写入 arena 而不是逐个 make_shared，返回根节点下标
+    NodeId parse(AstArena &arena);
+    // 通过 hash-consing 工厂构造，结构相同的子树共享同一个节点
+    std::shared_ptr<ASTNode> parse(NodeFactory &factory);
 
 private:
-    const std::vector<Token> &tokens;
+    const TokenBuffer *tokens; // 两种来源二选一
+    Lexer *lexer;
     size_t pos;
+    size_t end; // TokenBuffer 模式下 Token 的结束位置
     Token current_token;
 
-    void advance();
+    // 每个 Token 都会调用，放在头文件中以便内联
+    void advance()
+    {
+        ++pos;
+        if (lexer)
+            current_token = lexer->next();
+        else
+            current_token = pos < end ? (*tokens)[pos] : Token(TokenType::END_OF_FILE, "");
+    }
     void eat(TokenType type);
+    void recordStats(size_t nodes) const;
 
-    // 语法规则函数（优先级从低到高)
-    std::shared_ptr<ASTNode> parse_expression(); // +, -
-    std::shared_ptr<ASTNode> parse_term();       // *, /
-    std::shared_ptr<ASTNode> parse_factor();     // ^ (Power)
-    std::shared_ptr<ASTNode> parse_primary();    // Number, Var, Parentheses, Functions
+    // 解析一个完整的表达式，停在第一个不能继续的 Token 上
+    // Builder 决定节点如何构造：shared_ptr 树、AstArena 或 NodeFactory
+    template <typename Builder>
+    typename Builder::Ref parse_expression(Builder &builder);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,236 @@
+/**
+ * @file PerfStats.cpp
+ * @brief Implements the per-thread performance counters.
+ *
+ * Each thread has a block of counters in thread-local storage, written only by that thread
+ * (relaxed atomics, so readers in other threads see torn-free values). A thread registers its
+ * block on the first recorded event; when the thread exits, its totals move into a retired
+ * sum so process() does not lose them.
+ *
+ * Allocations are reported by the replacement operator new in CountingNew.cpp, which is
+ * linked only into the binaries that want them.
+ */
+#include "PerfStats.h"
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+
+constexpr size_t kFieldCount = 5;
+
+// 零初始化即可使用（不需要动态初始化），operator new 中访问也是安全的
+struct ThreadCounters
+{
+    std::atomic<std::uint64_t> calls[kPhaseCount];
+    std::atomic<std::uint64_t> nanos[kPhaseCount];
+    std::atomic<std::uint64_t> fields[kFieldCount];
+    std::atomic<std::uint64_t> peak;
+};
+
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<const ThreadCounters *> live;
+    PerfCounters retired;
+};
+
+// 故意不释放：其他线程退出时可能晚于静态析构
+Registry &registry()
+{
+    static Registry *instance = new Registry;
+    return *instance;
+}
+
+thread_local ThreadCounters counters;
+thread_local bool registered = false;
+
+// 只有所属线程写入，不需要读-改-写指令
+void bump(std::atomic<std::uint64_t> &value, std::uint64_t amount)
+{
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+PerfCounters snapshot(const ThreadCounters &c)
+{
+    PerfCounters out;
+    for (size_t i = 0; i < kPhaseCount; ++i)
+    {
+        out.calls[i] = c.calls[i].load(std::memory_order_relaxed);
+        out.nanos[i] = c.nanos[i].load(std::memory_order_relaxed);
+    }
+    out.tokens = c.fields[0].load(std::memory_order_relaxed);
+    out.astNodes = c.fields[1].load(std::memory_order_relaxed);
+    out.opaqueAtoms = c.fields[2].load(std::memory_order_relaxed);
+    out.allocations = c.fields[3].load(std::memory_order_relaxed);
+    out.allocatedBytes = c.fields[4].load(std::memory_order_relaxed);
+    out.peakTerms = c.peak.load(std::memory_order_relaxed);
+    return out;
+}
+
+// 线程退出时把计数并入 retired
+struct Retirer
+{
+    ~Retirer()
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.retired += snapshot(counters);
+        r.live.erase(std::remove(r.live.begin(), r.live.end(), &counters), r.live.end());
+    }
+};
+
+ThreadCounters &local()
+{
+    if (!registered)
+    {
+        // 先置位：注册过程本身的分配会再次进入这里
+        registered = true;
+        Registry &r = registry();
+        {
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.live.push_back(&counters);
+        }
+        static thread_local Retirer retirer;
+        (void)retirer;
+    }
+    return counters;
+}
+
+} // namespace
+
+const char *phaseName(Phase phase)
+{
+    switch (phase)
+    {
+    case Phase::Tokenize:
+        return "tokenize";
+    case Phase::Parse:
+        return "parse";
+    case Phase::Standardize:
+        return "standardize";
+    case Phase::SortAndMerge:
+        return "sortAndMerge";
+    case Phase::PolyToString:
+        return "polyToString";
+    default:
+        return "?";
+    }
+}
+
+PerfCounters &PerfCounters::operator+=(const PerfCounters &other)
+{
+    for (size_t i = 0; i < kPhaseCount; ++i)
+    {
+        calls[i] += other.calls[i];
+        nanos[i] += other.nanos[i];
+    }
+    tokens += other.tokens;
+    astNodes += other.astNodes;
+    opaqueAtoms += other.opaqueAtoms;
+    allocations += other.allocations;
+    allocatedBytes += other.allocatedBytes;
+    peakTerms = std::max(peakTerms, other.peakTerms);
+    return *this;
+}
+
+void PerfCounters::print(std::ostream &out) const
+{
+    out << std::left << std::setw(14) << "phase" << std::right << std::setw(12) << "calls" << std::setw(14)
+        << "total ms" << std::setw(12) << "avg ns" << '\n';
+    for (size_t i = 0; i < kPhaseCount; ++i)
+    {
+        out << std::left << std::setw(14) << phaseName(static_cast<Phase>(i)) << std::right << std::setw(12)
+            << calls[i] << std::setw(14) << std::fixed << std::setprecision(3) << nanos[i] / 1e6 << std::setw(12)
+            << std::setprecision(0) << (calls[i] ? double(nanos[i]) / calls[i] : 0.0) << '\n';
+    }
+    out.unsetf(std::ios::floatfield);
+    out << "tokens: " << tokens << ", AST nodes: " << astNodes << ", opaque atoms: " << opaqueAtoms
+        << ", peak terms: " << peakTerms << '\n';
+    out << "allocations: " << allocations << " (" << allocatedBytes << " bytes)" << '\n';
+}
+
+void PerfCounters::printJson(std::ostream &out) const
+{
+    out << "{\"phases\": {";
+    for (size_t i = 0; i < kPhaseCount; ++i)
+    {
+        out << (i ? ", " : "") << '"' << phaseName(static_cast<Phase>(i)) << "\": {\"calls\": " << calls[i]
+            << ", \"ns\": " << nanos[i] << '}';
+    }
+    out << "}, \"tokens\": " << tokens << ", \"ast_nodes\": " << astNodes << ", \"opaque_atoms\": " << opaqueAtoms
+        << ", \"peak_terms\": " << peakTerms << ", \"allocations\": " << allocations
+        << ", \"allocated_bytes\": " << allocatedBytes << '}';
+}
+
+PerfCounters PerfStats::thisThread()
+{
+    // 只读，不注册线程
+    return snapshot(counters);
+}
+
+PerfCounters PerfStats::process()
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    PerfCounters total = r.retired;
+    for (const ThreadCounters *c : r.live)
+        total += snapshot(*c);
+    return total;
+}
+
+void PerfStats::record(Field field, std::uint64_t amount)
+{
+    bump(local().fields[static_cast<size_t>(field)], amount);
+}
+
+void PerfStats::recordPeak(std::uint64_t count)
+{
+    std::atomic<std::uint64_t> &peak = local().peak;
+    if (count > peak.load(std::memory_order_relaxed))
+        peak.store(count, std::memory_order_relaxed);
+}
+
+void PerfStats::addAllocation(size_t bytes)
+{
+    ThreadCounters &c = local();
+    bump(c.fields[static_cast<size_t>(Field::Allocations)], 1);
+    bump(c.fields[static_cast<size_t>(Field::AllocatedBytes)], bytes);
+}
+
+void PerfStats::Timer::stop()
+{
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    ThreadCounters &c = local();
+    size_t i = static_cast<size_t>(phase);
+    bump(c.calls[i], 1);
+    bump(c.nanos[i], std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+PerfStats::Request::Request() : before(thisThread())
+{
+    // 请求内的峰值单独统计，结束时再与外层合并
+    outerPeak = counters.peak.load(std::memory_order_relaxed);
+    counters.peak.store(0, std::memory_order_relaxed);
+}
+
+PerfCounters PerfStats::Request::finish()
+{
+    PerfCounters after = thisThread();
+    PerfCounters out;
+    for (size_t i = 0; i < kPhaseCount; ++i)
+    {
+        out.calls[i] = after.calls[i] - before.calls[i];
+        out.nanos[i] = after.nanos[i] - before.nanos[i];
+    }
+    out.tokens = after.tokens - before.tokens;
+    out.astNodes = after.astNodes - before.astNodes;
+    out.opaqueAtoms = after.opaqueAtoms - before.opaqueAtoms;
+    out.allocations = after.allocations - before.allocations;
+    out.allocatedBytes = after.allocatedBytes - before.allocatedBytes;
+    out.peakTerms = after.peakTerms;
+    counters.peak.store(std::max(outerPeak, after.peakTerms), std::memory_order_relaxed);
+    return out;
+}
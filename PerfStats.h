@@ -0,0 +1,154 @@
+/**
+ * @file PerfStats.h
+ * @brief Declares the per-phase performance counters of the analyzer.
+ *
+ * Lexer, Parser, EqualityChecker and Polynomial report into a set of counters: wall time and
+ * call count per phase, tokens, AST nodes, opaque atoms, the largest term list seen, and heap
+ * allocations.
+ *
+ * Allocations are counted by CountingNew.cpp, which replaces every form of the global
+ * operator new/delete for the whole program. It is therefore not a library object: the
+ * Makefile links it only into ./main and the benchmarks that measure allocations. In other
+ * binaries the allocation counters stay zero.
+ *
+ * Every thread owns its counters, so recording never contends; PerfStats::process() sums
+ * all threads (including ones that already exited). A PerfStats::Request scope yields the
+ * counters of one request on the current thread.
+ *
+ * Collection is off by default. When off, each hook is one relaxed load of a global flag and
+ * a predictable branch; phase timers do not read the clock.
+ *
+ * Phases nest: Standardize includes the SortAndMerge calls made inside it, and Parse in
+ * streaming mode (Parser(Lexer&)) includes the lexing.
+ */
+#ifndef PERFSTATS_H
+#define PERFSTATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+enum class Phase : std::uint8_t
+{
+    Tokenize,
+    Parse,
+    Standardize,
+    SortAndMerge, // Polynomial::canonicalize
+    PolyToString,
+    Count
+};
+
+constexpr size_t kPhaseCount = static_cast<size_t>(Phase::Count);
+
+const char *phaseName(Phase phase);
+
+struct PerfCounters
+{
+    std::uint64_t calls[kPhaseCount] = {};
+    std::uint64_t nanos[kPhaseCount] = {};
+    std::uint64_t tokens = 0;
+    std::uint64_t astNodes = 0;
+    std::uint64_t opaqueAtoms = 0; // 作为整体处理的函数、除法和未展开的幂
+    std::uint64_t allocations = 0;
+    std::uint64_t allocatedBytes = 0;
+    std::uint64_t peakTerms = 0; // 规范化时见到的最长项列表（取最大值，不累加）
+
+    // 求和，peakTerms 取最大值
+    PerfCounters &operator+=(const PerfCounters &other);
+
+    void print(std::ostream &out) const;     // 可读的多行文本
+    void printJson(std::ostream &out) const; // 单个 JSON 对象
+};
+
+class PerfStats
+{
+public:
+    static bool enabled() { return flag.load(std::memory_order_relaxed); }
+    static void setEnabled(bool on) { flag.store(on, std::memory_order_relaxed); }
+
+    // 当前线程的累计值
+    static PerfCounters thisThread();
+    // 所有线程（含已退出的线程）的累计值
+    static PerfCounters process();
+
+    // 以下钩子在关闭时只检查一次开关
+    static void addTokens(size_t count)
+    {
+        if (enabled())
+            record(Field::Tokens, count);
+    }
+    static void addAstNodes(size_t count)
+    {
+        if (enabled())
+            record(Field::AstNodes, count);
+    }
+    static void addOpaqueAtom()
+    {
+        if (enabled())
+            record(Field::OpaqueAtoms, 1);
+    }
+    static void notePeakTerms(size_t count)
+    {
+        if (enabled())
+            recordPeak(count);
+    }
+
+    // 统计作用域内的耗时和调用次数
+    class Timer
+    {
+    public:
+        explicit Timer(Phase phase) : phase(phase), active(enabled())
+        {
+            if (active)
+                start = std::chrono::steady_clock::now();
+        }
+        ~Timer()
+        {
+            if (active)
+                stop();
+        }
+        Timer(const Timer &) = delete;
+        Timer &operator=(const Timer &) = delete;
+
+    private:
+        Phase phase;
+        bool active;
+        std::chrono::steady_clock::time_point start;
+
+        void stop();
+    };
+
+    // 一次请求：finish() 返回从构造到此刻当前线程的计数（peakTerms 只看请求内部）
+    class Request
+    {
+    public:
+        Request();
+        PerfCounters finish();
+
+    private:
+        PerfCounters before;
+        std::uint64_t outerPeak;
+    };
+
+    // 由 CountingNew.cpp 中替换的 operator new 调用
+    static void addAllocation(size_t bytes);
+
+private:
+    enum class Field : std::uint8_t
+    {
+        Tokens,
+        AstNodes,
+        OpaqueAtoms,
+        Allocations,
+        AllocatedBytes
+    };
+
+    static inline std::atomic<bool> flag{false};
+
+    static void record(Field field, std::uint64_t amount);
+    static void recordPeak(std::uint64_t count);
+};
+
+#endif // PERFSTATS_H
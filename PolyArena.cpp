@@ -0,0 +1,33 @@
+/**
+ * @file PolyArena.cpp
+ * @brief Implements the thread-local current resource behind PolyAllocator.
+ */
+#include "PolyArena.h"
+
+namespace {
+
+// 每个线程一块可复用的初始缓冲区：小的比较完全不需要向堆申请内存
+constexpr std::size_t kInitialBuffer = 64 * 1024;
+
+thread_local std::pmr::memory_resource* currentResource = nullptr;
+
+std::byte* threadBuffer() {
+    alignas(std::max_align_t) thread_local std::byte buffer[kInitialBuffer];
+    return buffer;
+}
+
+} // namespace
+
+PolyArena::PolyArena()
+    : resource(threadBuffer(), kInitialBuffer), outermost(currentResource == nullptr) {
+    // 嵌套时继续使用外层的资源（它的生存期覆盖内层），本对象的 resource 不会被用到
+    if (outermost) currentResource = &resource;
+}
+
+PolyArena::~PolyArena() {
+    if (outermost) currentResource = nullptr;
+}
+
+std::pmr::memory_resource* PolyArena::current() {
+    return currentResource;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file PolyArena.h
+ * @brief Declares the per-comparison memory arena for polynomial temporaries.
+ *
+ * Standardization creates and drops many small vectors: the term lists of every
+ * intermediate polynomial and the symbol list of every term. PolyAllocator takes its
+ * memory from the thread's current memory resource, which is the global heap unless a
+ * PolyArena scope is active. A PolyArena installs a std::pmr::monotonic_buffer_resource:
+ * allocation is a pointer bump, deallocation does nothing, and everything is released at
+ * once when the scope ends. The outermost PolyArena of a thread starts from a reusable 64 KB
+ * thread-local buffer, so small comparisons do not touch the heap at all; nested scopes
+ * keep using the outer arena.
+ *
+ * A container keeps the resource it was created with, so nothing allocated inside a
+ * PolyArena may outlive it. Copies follow the resource that is current at the copy, not
+ * the resource of the source (select_on_container_copy_construction), so copying a
+ * polynomial out of the scope is safe; moving one out is not.
+ */
+#ifndef POLYARENA_H
+#define POLYARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <type_traits>
+#include <vector>
+
+class PolyArena {
+public:
+    PolyArena();
+    ~PolyArena();
+
+    PolyArena(const PolyArena&) = delete;
+    PolyArena& operator=(const PolyArena&) = delete;
+
+    // 当前线程的内存来源：外层 PolyArena 的资源，没有时为 nullptr（全局堆）
+    static std::pmr::memory_resource* current();
+
+private:
+    std::pmr::monotonic_buffer_resource resource;
+    bool outermost; // 嵌套的 PolyArena 沿用外层的资源
+};
+
+template <typename T>
+class PolyAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    // 构造时记下当前线程的资源
+    PolyAllocator() noexcept : resource(PolyArena::current()) {}
+    template <typename U>
+    PolyAllocator(const PolyAllocator<U>& other) noexcept : resource(other.resource) {}
+
+    // 没有 arena 时直接走 operator new，省去一次虚调用
+    T* allocate(std::size_t n) {
+        if (!resource) return static_cast<T*>(::operator new(n * sizeof(T)));
+        return static_cast<T*>(resource->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T* p, std::size_t n) noexcept {
+        if (!resource) {
+            ::operator delete(p);
+            return;
+        }
+        resource->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    // 拷贝得到的容器使用拷贝时的当前资源
+    PolyAllocator select_on_container_copy_construction() const { return PolyAllocator(); }
+
+    template <typename U>
+    bool operator==(const PolyAllocator<U>& other) const noexcept { return resource == other.resource; }
+    template <typename U>
+    bool operator!=(const PolyAllocator<U>& other) const noexcept { return resource != other.resource; }
+
+private:
+    template <typename U>
+    friend class PolyAllocator;
+
+    std::pmr::memory_resource* resource; // nullptr 表示全局堆
+};
+
+template <typename T>
+using PolyVector = std::vector<T, PolyAllocator<T>>;
+
+#endif // POLYARENA_H
@@ -0,0 +1,261 @@
+/**
+ * @file Polynomial.cpp
+ * @brief Implements merging and text rendering of polynomials.
+ */
+#include "Polynomial.h"
+#include "SymbolTable.h"
+#include "PerfStats.h"
+#include <algorithm>
+#include <cctype>
+
+std::size_t Polynomial::hashVars(const PolyVector<SymbolId>& vars) {
+    std::uint64_t h = 0xcbf29ce484222325ULL ^ vars.size();
+    for (SymbolId id : vars) {
+        h ^= id;
+        h *= 0x100000001b3ULL;
+        h ^= h >> 29;
+    }
+    return static_cast<std::size_t>(h);
+}
+
+void Polynomial::rebuildIndex(size_t capacity) {
+    slots.assign(capacity, 0);
+    size_t mask = capacity - 1;
+    for (size_t i = 0; i < items.size(); ++i) {
+        size_t pos = hashVars(items[i].vars) & mask;
+        while (slots[pos] != 0) pos = (pos + 1) & mask;
+        slots[pos] = static_cast<std::uint32_t>(i + 1);
+    }
+}
+
+Term* Polynomial::find(const PolyVector<SymbolId>& vars, size_t& slot) {
+    // 负载因子保持在 1/2 以下；canonicalize 之后 slots 为空，需要重建
+    if ((items.size() + 1) * 2 > slots.size()) {
+        size_t capacity = 16;
+        while (capacity < (items.size() + 1) * 2) capacity *= 2;
+        rebuildIndex(capacity);
+    }
+    size_t mask = slots.size() - 1;
+    size_t pos = hashVars(vars) & mask;
+    while (slots[pos] != 0) {
+        Term& existing = items[slots[pos] - 1];
+        if (existing.vars == vars) return &existing;
+        pos = (pos + 1) & mask;
+    }
+    slot = pos;
+    return nullptr;
+}
+
+void Polynomial::accumulate(Term& existing, const Coefficient& coeff) {
+    bool wasNarrow = existing.coeff.isNarrow();
+    Fingerprint before = wasNarrow ? Fingerprint() : Fingerprint::wide(existing.coeff);
+    existing.coeff += coeff;
+    if (wasNarrow && existing.coeff.isNarrow()) return;
+    widePrint += (Fingerprint::wide(existing.coeff) - before) * existing.value;
+}
+
+void Polynomial::recomputeWide() {
+    widePrint = Fingerprint();
+    for (const auto& term : items) {
+        if (!term.coeff.isNarrow()) widePrint += Fingerprint::wide(term.coeff) * term.value;
+    }
+}
+
+void Polynomial::merge(Term term) {
+    canonical = false;
+    size_t slot = 0;
+    if (Term* existing = find(term.vars, slot)) {
+        accumulate(*existing, term.coeff);
+        return;
+    }
+    if (!term.coeff.isNarrow()) widePrint += Fingerprint::wide(term.coeff) * term.value;
+    slots[slot] = static_cast<std::uint32_t>(items.size() + 1);
+    items.push_back(std::move(term));
+}
+
+Term::Term(Coefficient coeff, PolyVector<SymbolId> vars)
+    : coeff(std::move(coeff)), vars(std::move(vars)) {
+    for (SymbolId id : this->vars) value = value * SymbolTable::global().fingerprint(id);
+}
+
+void Polynomial::add(Term term) {
+    print += Fingerprint::constant(term.coeff) * term.value;
+    merge(std::move(term));
+}
+
+void Polynomial::addProduct(const Coefficient& coeff, const Term& a, const Term& b) {
+    canonical = false;
+    scratch.resize(a.vars.size() + b.vars.size());
+    std::merge(a.vars.begin(), a.vars.end(), b.vars.begin(), b.vars.end(), scratch.begin());
+    size_t slot = 0;
+    if (Term* existing = find(scratch, slot)) {
+        existing->coeff += coeff;
+        return;
+    }
+    slots[slot] = static_cast<std::uint32_t>(items.size() + 1);
+    items.push_back(Term{coeff, scratch, a.value * b.value});
+}
+
+void Polynomial::add(const Polynomial& other, int sign) {
+    print += sign < 0 ? -other.print : other.print;
+    for (const auto& term : other.items) {
+        Term copy = term;
+        if (sign < 0) copy.coeff.negate();
+        merge(std::move(copy));
+    }
+}
+
+void Polynomial::add(Polynomial&& other, int sign) {
+    Fingerprint sum = print + (sign < 0 ? -other.print : other.print);
+    // 把较小的一方并入较大的一方
+    if (other.items.size() > items.size()) {
+        std::swap(*this, other);
+        if (sign < 0) negate();
+        sign = 1;
+    }
+    for (auto& term : other.items) {
+        if (sign < 0) term.coeff.negate();
+        merge(std::move(term));
+    }
+    print = sum;
+}
+
+Polynomial multiply(const Polynomial& left, const Polynomial& right) {
+    Polynomial result;
+    Coefficient scalar;
+    // 一边是常数时只需缩放系数
+    const Polynomial* other = nullptr;
+    if (right.isConstant(scalar)) {
+        other = &left;
+    } else if (left.isConstant(scalar)) {
+        other = &right;
+    }
+    if (other) {
+        if (scalar.isZero()) return result;
+        for (const auto& term : other->terms()) {
+            if (!term.coeff.isZero()) result.merge(Term{term.coeff * scalar, term.vars, term.value});
+        }
+        result.print = left.print * right.print;
+        return result;
+    }
+    for (const auto& l : left.terms()) {
+        if (l.coeff.isZero()) continue;
+        for (const auto& r : right.terms()) {
+            if (r.coeff.isZero()) continue;
+            result.addProduct(l.coeff * r.coeff, l, r);
+        }
+    }
+    // 大系数可能被累加多次，最后逐项算一次比每次累加时都更新便宜
+    result.recomputeWide();
+    result.print = left.print * right.print;
+    return result;
+}
+
+Polynomial power(const Polynomial& base, int exponent) {
+    Polynomial result;
+    result.add(Term{1, {}});
+    Polynomial square = base;
+    while (exponent > 0) {
+        if (exponent & 1) result = multiply(result, square);
+        exponent >>= 1;
+        if (exponent > 0) square = multiply(square, square);
+    }
+    return result;
+}
+
+void Polynomial::negate() {
+    for (auto& term : items) term.coeff.negate();
+    print = -print;
+    widePrint = -widePrint;
+}
+
+const TermList& Polynomial::canonicalize() {
+    if (!canonical) {
+        PerfStats::Timer timer(Phase::SortAndMerge);
+        PerfStats::notePeakTerms(items.size());
+        // 移除系数为0的项
+        items.erase(std::remove_if(items.begin(), items.end(),
+                                   [](const Term& t) { return t.coeff.isZero(); }),
+                    items.end());
+        std::sort(items.begin(), items.end());
+        slots.clear();
+        canonical = true;
+    }
+    return items;
+}
+
+size_t Polynomial::size() const {
+    size_t count = 0;
+    for (const auto& term : items) {
+        if (!term.coeff.isZero()) ++count;
+    }
+    return count;
+}
+
+bool Polynomial::isConstant(Coefficient& value) const {
+    value = 0;
+    for (const auto& term : items) {
+        if (term.coeff.isZero()) continue;
+        if (!term.vars.empty()) return false;
+        value = term.coeff;
+    }
+    return true;
+}
+
+std::string polyToString(const TermList& poly) {
+    PerfStats::Timer timer(Phase::PolyToString);
+    // 符号 ID 的大小取决于驻留顺序，输出前按名字重新排序，保证文本唯一且稳定
+    struct NamedTerm {
+        Coefficient coeff;
+        std::vector<const std::string*> names;
+    };
+    SymbolTable& symbols = SymbolTable::global();
+    std::vector<NamedTerm> named;
+    named.reserve(poly.size());
+    for (const auto& term : poly) {
+        if (term.coeff.isZero()) continue;
+        NamedTerm nt;
+        nt.coeff = term.coeff;
+        for (SymbolId id : term.vars) nt.names.push_back(&symbols.name(id));
+        std::sort(nt.names.begin(), nt.names.end(),
+                  [](const std::string* a, const std::string* b) { return *a < *b; });
+        named.push_back(std::move(nt));
+    }
+    std::sort(named.begin(), named.end(), [](const NamedTerm& a, const NamedTerm& b) {
+        if (!std::equal(a.names.begin(), a.names.end(), b.names.begin(), b.names.end(),
+                        [](const std::string* x, const std::string* y) { return *x == *y; })) {
+            return std::lexicographical_compare(a.names.begin(), a.names.end(), b.names.begin(), b.names.end(),
+                                                [](const std::string* x, const std::string* y) { return *x < *y; });
+        }
+        return a.coeff < b.coeff;
+    });
+
+    std::string s = "";
+    for (size_t i = 0; i < named.size(); ++i) {
+        const auto& term = named[i];
+
+        // 正数系数
+        if (term.coeff.sign() > 0 && i > 0) s += "+";
+        // 负数系数
+        if (term.coeff.sign() < 0) s += "-"; 
+        std::string termStr = "";
+        // 如果系数不是 1/-1，或者没有变量因子，则显示系数
+        if (!term.coeff.isUnit() || term.names.empty()) {
+            termStr += term.coeff.absString();
+        }
+        
+        // 连接所有变量因子
+        for (const std::string* var : term.names) {
+            if (!termStr.empty() && isdigit(termStr.back())) termStr += "*"; // 可选：加乘号
+            termStr += *var;
+        }
+        s += termStr;
+    }
+    
+    if (s.empty()) return "0";
+    return s;
+}
+
+std::string polyToString(const Polynomial& poly) {
+    return polyToString(poly.terms());
+}
@@ -0,0 +1,134 @@
+/**
+ * @file Polynomial.h
+ * @brief Declares the sum-of-products polynomial representation used for normalization.
+ *
+ * A polynomial is a list of Terms. Each Term is an integer coefficient (an overflow-safe
+ * Coefficient, see Coefficient.h) times a product of
+ * symbols, where a symbol is an interned SymbolId (see SymbolTable.h) standing for either a
+ * variable or an opaque sub-expression. All comparisons and merging work on integer IDs;
+ * text is produced only by polyToString().
+ *
+ * Polynomial accumulates terms through a hash index keyed by monomial, so like terms are
+ * combined in O(1) as they are added. Sorting happens once, in canonicalize(), when a
+ * canonical form is actually needed (final comparison, output, or an opaque atom's operand).
+ *
+ * Each polynomial also carries its 128-bit Fingerprint (see Fingerprint.h), updated as terms
+ * are added, so a canonical polynomial can be hashed, indexed or compared against a stored
+ * form in O(1), and two different polynomials are usually told apart without looking at
+ * their terms.
+ *
+ * Every vector inside a polynomial uses PolyAllocator, so inside a PolyArena scope (one
+ * per areEqual call) all of them come from a monotonic buffer that is released in one go.
+ */
+#ifndef POLYNOMIAL_H
+#define POLYNOMIAL_H
+
+#include "Coefficient.h"
+#include "Fingerprint.h"
+#include "PolyArena.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+using SymbolId = std::uint32_t;
+
+// 代表多项式中的一项
+struct Term {
+    Coefficient coeff;
+    PolyVector<SymbolId> vars; // 升序排列，重复出现表示幂次
+    Fingerprint value{1, 1};   // 单项式（不含系数）的指纹；默认是没有符号的单项式 1
+
+    Term() = default;
+    // value 取各符号坐标之积（没有符号时为 1）
+    Term(Coefficient coeff, PolyVector<SymbolId> vars);
+    // 已知单项式的指纹时直接给出，免去查符号表
+    Term(Coefficient coeff, PolyVector<SymbolId> vars, const Fingerprint& value)
+        : coeff(std::move(coeff)), vars(std::move(vars)), value(value) {}
+
+    // 排序：先比变量部分，再比系数
+    bool operator<(const Term& other) const {
+        if (vars != other.vars) return vars < other.vars;
+        return coeff < other.coeff;
+    }
+
+    bool operator==(const Term& other) const {
+        return coeff == other.coeff && vars == other.vars;
+    }
+
+    // 判断变量部分是否相同（用于合并同类项）
+    bool isSameVars(const Term& other) const {
+        return vars == other.vars;
+    }
+};
+
+using TermList = PolyVector<Term>;
+
+class Polynomial {
+public:
+    Polynomial() = default;
+
+    // 累加一项，与已有的同类项合并
+    void add(Term term);
+    // 累加 sign * other
+    void add(const Polynomial& other, int sign = 1);
+    void add(Polynomial&& other, int sign = 1);
+    void negate();
+
+    // 去掉系数为 0 的项并按变量排序，返回规范的项列表
+    const TermList& canonicalize();
+    // 当前的项（可能含系数为 0 的项、顺序任意，除非刚调用过 canonicalize）
+    const TermList& terms() const { return items; }
+    bool isCanonical() const { return canonical; }
+    // 非零项的个数
+    size_t size() const;
+    // 若多项式是一个常数（含 0），写入 value 并返回 true
+    bool isConstant(Coefficient& value) const;
+    // 与项的顺序和是否规范化无关，O(1)
+    Fingerprint fingerprint() const { return print + widePrint; }
+
+    // 两边都必须已规范化；指纹不同时不再逐项比较
+    bool operator==(const Polynomial& other) const {
+        return print == other.print && widePrint == other.widePrint && items == other.items;
+    }
+    bool operator!=(const Polynomial& other) const { return !(*this == other); }
+
+private:
+    friend Polynomial multiply(const Polynomial& left, const Polynomial& right);
+
+    TermList items;
+    // 开放寻址哈希表，存放 items 的下标 + 1（0 表示空槽）
+    PolyVector<std::uint32_t> slots;
+    bool canonical = true;
+    Fingerprint print;     // 各项系数（模 p）与单项式指纹之积的和
+    Fingerprint widePrint; // 绝对值不小于 2^60 的各项系数另加的部分，由合并同类项时维护
+
+    PolyVector<SymbolId> scratch; // addProduct 的临时缓冲区
+
+    static std::size_t hashVars(const PolyVector<SymbolId>& vars);
+    void rebuildIndex(size_t capacity);
+    // 返回 vars 对应的项；若不存在则返回 nullptr，并把可插入的槽位写入 slot
+    Term* find(const PolyVector<SymbolId>& vars, size_t& slot);
+    // 并入一项（其 value 已计算），只更新 widePrint
+    void merge(Term term);
+    // existing.coeff += coeff，并更新 widePrint
+    void accumulate(Term& existing, const Coefficient& coeff);
+    // 逐项重新计算 widePrint
+    void recomputeWide();
+    // 并入 coeff * (a · b)，只有出现新单项式时才分配内存；不更新指纹，由 multiply 最后一次设置
+    void addProduct(const Coefficient& coeff, const Term& a, const Term& b);
+};
+
+// 稀疏多项式乘法：逐对相乘时归并有序变量列表（无需再排序），并在哈希索引中即时合并同类项，
+// 中间结果的大小不超过最终结果的项数
+Polynomial multiply(const Polynomial& left, const Polynomial& right);
+
+// 非负整数次幂，使用二进制快速幂（平方-乘），只需 O(log exponent) 次乘法
+Polynomial power(const Polynomial& base, int exponent);
+
+// 将标准化后的多项式转为唯一字符串（与符号 ID 的分配顺序无关，系数为 0 的项被忽略）
+std::string polyToString(const TermList& poly);
+std::string polyToString(const Polynomial& poly);
+
+#endif // POLYNOMIAL_H
@@ -0,0 +1,348 @@
+/**
+ * @file RandomEvaluator.cpp
+ * @brief Implements evaluation of expressions modulo 2^61 - 1 at random points.
+ */
+#include "RandomEvaluator.h"
+#include "Coefficient.h"
+#include "EqualityChecker.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+constexpr std::uint64_t P = RandomEvaluator::kPrime;
+
+std::uint64_t addMod(std::uint64_t a, std::uint64_t b) {
+    std::uint64_t r = a + b;
+    return r >= P ? r - P : r;
+}
+
+std::uint64_t subMod(std::uint64_t a, std::uint64_t b) {
+    return a >= b ? a - b : a + P - b;
+}
+
+// 2^61 ≡ 1 (mod p)，高位折叠回低位即可约简
+std::uint64_t mulMod(std::uint64_t a, std::uint64_t b) {
+    unsigned __int128 z = static_cast<unsigned __int128>(a) * b;
+    std::uint64_t r = (static_cast<std::uint64_t>(z) & P) + static_cast<std::uint64_t>(z >> 61);
+    return r >= P ? r - P : r;
+}
+
+std::uint64_t powMod(std::uint64_t base, std::uint64_t exp) {
+    std::uint64_t result = 1;
+    while (exp > 0) {
+        if (exp & 1) result = mulMod(result, base);
+        base = mulMod(base, base);
+        exp >>= 1;
+    }
+    return result;
+}
+
+// splitmix64 的终结函数
+std::uint64_t mix(std::uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// 求值栈上的一项。value 是本次取值点上的值；probe 是同一次取值中另一个独立点上的值，
+// 两者相同说明这棵子树（以 1-d/p 的概率）是常数，用来识别 x-x+2 这类要消去才是常数的指数。
+// constant 表示子树由整数字面量经 + - * ^ 折叠而来，exact 是它的精确值；
+// 折叠结果超出机器字时放弃（值仍然按模计算），避免长串常数运算变成二次的。
+// norm 是子树展开后各项系数绝对值之和的上界（不可解释的整体算作系数为 1 的符号），
+// 到 kNormLimit 封顶：它小于 kNormLimit 时两边任一系数之差的绝对值都小于 p，取模不会混同
+struct Entry {
+    std::uint64_t value = 0;
+    std::uint64_t probe = 0;
+    bool constant = false;
+    Coefficient exact;
+    std::uint64_t norm = 0;
+};
+
+// 消去后得到的常数只知道模 p 的值：小于 2^60 的视为非负整数，其余视为负数
+constexpr std::uint64_t kMaxProbedExponent = std::uint64_t(1) << 60;
+// 常数的幂只在指数不超过这个值时折叠
+constexpr int kMaxFoldedExponent = 64;
+
+// 系数上界达到 2^60 时不再可信：两边的系数各自小于 2^60，差才一定小于 p
+constexpr std::uint64_t kNormLimit = std::uint64_t(1) << 60;
+
+std::uint64_t addNorm(std::uint64_t a, std::uint64_t b) { return std::min(a + b, kNormLimit); }
+
+std::uint64_t mulNorm(std::uint64_t a, std::uint64_t b) {
+    unsigned __int128 z = static_cast<unsigned __int128>(a) * b;
+    return z >= kNormLimit ? kNormLimit : static_cast<std::uint64_t>(z);
+}
+
+// ||P^k||_1 <= ||P||_1^k
+std::uint64_t powNorm(std::uint64_t base, std::uint64_t exp) {
+    std::uint64_t result = 1;
+    while (exp > 0) {
+        if (exp & 1) result = mulNorm(result, base);
+        if (result == kNormLimit || exp == 1) break;
+        base = mulNorm(base, base);
+        exp >>= 1;
+    }
+    return result;
+}
+
+// 一次取值的状态：两个取值点的盐。outOfRange 记录是否有子树的系数上界达到 kNormLimit
+// （常数或常数指数较大、或者乘积使系数变大）：这时不同的表达式可能在每个取值点上都相同，
+// 取值相同不能作为结论
+struct Evaluation {
+    std::uint64_t salt = 0;
+    std::uint64_t probeSalt = 0;
+    bool outOfRange = false;
+
+    void setTrial(std::uint64_t trialSalt) {
+        salt = trialSalt;
+        probeSalt = mix(trialSalt ^ 0x70726f6265ULL);
+    }
+
+
+    // 不可解释的符号：同样的标签和参数值得到同样的随机值
+    static std::uint64_t opaque(std::uint64_t salt, TokenType tag, std::uint64_t a, std::uint64_t b) {
+        return mix(mix(mix(salt ^ static_cast<std::uint64_t>(tag)) ^ a) ^ b) % P;
+    }
+
+    // exp 是指数对 p-1 取模后的值，zeroExponent 表示指数本身为 0
+    static std::uint64_t power(std::uint64_t base, std::uint64_t exp, bool zeroExponent) {
+        if (zeroExponent) return 1;
+        if (base == 0) return 0;
+        return powMod(base, exp);
+    }
+
+    // 每个结果都经过这里：上界达到 kNormLimit 后本次比较改用精确判等
+    void bound(Entry& e, std::uint64_t norm) {
+        e.norm = norm;
+        if (norm >= kNormLimit) outOfRange = true;
+    }
+
+    Entry number(std::string_view digits) {
+        Entry e;
+        e.exact = Coefficient::fromString(digits);
+        e.value = e.probe = e.exact.mod(P);
+        e.constant = true;
+        // 小于 2^60 的字面量取模后就是它本身
+        bound(e, e.exact.bitLength() <= 60 ? e.value : kNormLimit);
+        return e;
+    }
+
+    Entry variable(std::string_view name) const {
+        std::uint64_t h = hashText(name);
+        Entry e;
+        e.value = mix(salt ^ h) % P;
+        e.probe = mix(probeSalt ^ h) % P;
+        e.norm = 1;
+        return e;
+    }
+
+    void negate(Entry& e) const {
+        e.value = subMod(0, e.value);
+        e.probe = subMod(0, e.probe);
+        if (e.constant) {
+            e.exact.negate();
+            e.constant = e.exact.isSmall();
+        }
+    }
+
+    void function(TokenType funcType, Entry& e) const {
+        e.value = opaque(salt, funcType, e.value, 0);
+        e.probe = opaque(probeSalt, funcType, e.probe, 0);
+        e.constant = false;
+        e.norm = 1;
+    }
+
+    // 结果写回 left
+    void binary(TokenType op, Entry& left, const Entry& right) {
+        bool fold = left.constant && right.constant;
+        switch (op) {
+            case TokenType::PLUS:
+                left.value = addMod(left.value, right.value);
+                left.probe = addMod(left.probe, right.probe);
+                if (fold) left.exact += right.exact;
+                bound(left, addNorm(left.norm, right.norm));
+                break;
+            case TokenType::MINUS:
+                left.value = subMod(left.value, right.value);
+                left.probe = subMod(left.probe, right.probe);
+                if (fold) {
+                    Coefficient negated = right.exact;
+                    negated.negate();
+                    left.exact += negated;
+                }
+                bound(left, addNorm(left.norm, right.norm));
+                break;
+            case TokenType::MUL:
+                left.value = mulMod(left.value, right.value);
+                left.probe = mulMod(left.probe, right.probe);
+                if (fold) left.exact *= right.exact;
+                bound(left, mulNorm(left.norm, right.norm));
+                break;
+            case TokenType::DIV:
+                left.value = opaque(salt, TokenType::DIV, left.value, right.value);
+                left.probe = opaque(probeSalt, TokenType::DIV, left.probe, right.probe);
+                left.norm = 1;
+                fold = false;
+                break;
+            case TokenType::POW:
+                powerOf(left, right);
+                return;
+            default:
+                throw std::runtime_error("Unsupported binary operator");
+        }
+        left.constant = fold && left.exact.isSmall();
+    }
+
+    // 指数是非负整数常数时按幂计算（费马小定理：b^(p-1) ≡ 1，指数可对 p-1 取模），
+    // 否则作为不可解释的整体
+    void powerOf(Entry& base, const Entry& exponent) {
+        std::uint64_t exp = 0;
+        bool constant = false, zero = false;
+        if (exponent.constant) {
+            constant = exponent.exact.sign() >= 0;
+            zero = exponent.exact.isZero();
+            // 指数不小于 p-1 时 x^e 与 x^(e mod (p-1)) 在每个非零点上都相同，
+            // 但这时指数的上界已达到 kNormLimit，outOfRange 已经设置
+            if (constant) exp = exponent.exact.mod(P - 1);
+        } else if (exponent.value == exponent.probe && exponent.value < kMaxProbedExponent) {
+            constant = true;
+            zero = exponent.value == 0;
+            exp = exponent.value;
+        }
+        if (!constant) {
+            base.value = opaque(salt, TokenType::POW, base.value, exponent.value);
+            base.probe = opaque(probeSalt, TokenType::POW, base.probe, exponent.probe);
+            base.constant = false;
+            base.norm = 1;
+            return;
+        }
+        base.value = power(base.value, exp, zero);
+        base.probe = power(base.probe, exp, zero);
+        // 指数的上界小于 kNormLimit 时 exp 就是指数本身
+        bound(base, zero ? 1 : powNorm(base.norm, exp));
+        // 常数的幂按精确值检查是否超出 p；指数由消去得到时只检查，结果不算作折叠的常数
+        int k = -1;
+        if (exponent.constant) {
+            if (!exponent.exact.toInt(k)) k = -1;
+        } else if (exp <= static_cast<std::uint64_t>(kMaxFoldedExponent)) {
+            k = static_cast<int>(exp);
+        }
+        if (base.constant && k >= 0 && k <= kMaxFoldedExponent) {
+            Coefficient result = 1;
+            for (int i = 0; i < k && result.isSmall(); ++i) result *= base.exact;
+            base.exact = std::move(result);
+            base.constant = exponent.constant && base.exact.isSmall();
+        } else {
+            base.constant = false;
+        }
+    }
+};
+
+// 非递归求值：walkPostOrder 离开节点时按种类分派，子节点的结果取自 values 栈顶
+struct TreeEvaluator {
+    Evaluation& eval;
+    std::vector<Entry>& values;
+
+    std::uint64_t run(const ASTNode& root) const {
+        values.clear();
+        walkPostOrder(root, [](const ASTNode&) { return true; }, [&](const ASTNode& node) { visitNode(node, *this); });
+        return values.back().value;
+    }
+
+    void operator()(const NumberNode& n) const { values.push_back(eval.number(n.value)); }
+    void operator()(const VariableNode& v) const { values.push_back(eval.variable(v.name)); }
+    void operator()(const UnaryOpNode& u) const {
+        if (u.op == TokenType::MINUS) eval.negate(values.back());
+    }
+    void operator()(const BinaryOpNode& b) const {
+        eval.binary(b.op, values[values.size() - 2], values.back());
+        values.pop_back();
+    }
+    void operator()(const FunctionNode& f) const { eval.function(f.funcType, values.back()); }
+};
+
+std::uint64_t evaluateArena(Evaluation& eval, std::vector<Entry>& values, const AstArena& arena, NodeId root) {
+    if (root == kNullNode) return 0;
+
+    values.clear();
+    walkPostOrder(arena, root, [](NodeId) { return true; }, [&](NodeId id) {
+        const FlatNode& node = arena[id];
+        switch (node.kind) {
+            case NodeKind::Number:
+                values.push_back(eval.number(arena.text(id)));
+                return;
+            case NodeKind::Variable:
+                values.push_back(eval.variable(arena.text(id)));
+                return;
+            case NodeKind::UnaryOp:
+                if (node.op == TokenType::MINUS) eval.negate(values.back());
+                return;
+            case NodeKind::BinaryOp: {
+                eval.binary(node.op, values[values.size() - 2], values.back());
+                values.pop_back();
+                return;
+            }
+            case NodeKind::Function:
+                eval.function(node.op, values.back());
+                return;
+        }
+    });
+    return values.back().value;
+}
+
+} // namespace
+
+RandomEvaluator::RandomEvaluator(int trials, std::uint64_t seed) : trialCount(trials), seed(seed) {
+    if (trials <= 0) throw std::runtime_error("Number of trials must be positive");
+}
+
+std::uint64_t RandomEvaluator::evaluate(const ASTNode& node, int trial) const {
+    Evaluation eval;
+    eval.setTrial(mix(seed + static_cast<std::uint64_t>(trial)));
+    ScratchVector<Entry> values;
+    return TreeEvaluator{eval, values.items}.run(node);
+}
+
+std::uint64_t RandomEvaluator::evaluate(const AstArena& arena, NodeId node, int trial) const {
+    Evaluation eval;
+    eval.setTrial(mix(seed + static_cast<std::uint64_t>(trial)));
+    ScratchVector<Entry> values;
+    return evaluateArena(eval, values.items, arena, node);
+}
+
+EqualityVerdict RandomEvaluator::compare(const std::shared_ptr<ASTNode>& expr1,
+                                         const std::shared_ptr<ASTNode>& expr2) const {
+    Evaluation eval;
+    ScratchVector<Entry> values;
+    TreeEvaluator evaluator{eval, values.items};
+    for (int trial = 0; trial < trialCount; ++trial) {
+        eval.setTrial(mix(seed + static_cast<std::uint64_t>(trial)));
+        // 空树与标准化一致，视为 0
+        std::uint64_t value1 = expr1 ? evaluator.run(*expr1) : 0;
+        std::uint64_t value2 = expr2 ? evaluator.run(*expr2) : 0;
+        if (value1 != value2) return EqualityVerdict::Different;
+    }
+    if (eval.outOfRange) return EqualityChecker::areEqual(expr1, expr2) ? EqualityVerdict::Equal : EqualityVerdict::Different;
+    return EqualityVerdict::ProbablyEqual;
+}
+
+EqualityVerdict RandomEvaluator::compare(const AstArena& arena1, NodeId root1,
+                                         const AstArena& arena2, NodeId root2) const {
+    Evaluation eval;
+    ScratchVector<Entry> values;
+    for (int trial = 0; trial < trialCount; ++trial) {
+        eval.setTrial(mix(seed + static_cast<std::uint64_t>(trial)));
+        if (evaluateArena(eval, values.items, arena1, root1) != evaluateArena(eval, values.items, arena2, root2)) {
+            return EqualityVerdict::Different;
+        }
+    }
+    if (eval.outOfRange) {
+        PolyArena polyArena;
+        bool equal = EqualityChecker::standardize(arena1, root1) == EqualityChecker::standardize(arena2, root2);
+        return equal ? EqualityVerdict::Equal : EqualityVerdict::Different;
+    }
+    return EqualityVerdict::ProbablyEqual;
+}
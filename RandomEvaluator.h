@@ -0,0 +1,68 @@
+/**
+ * @file RandomEvaluator.h
+ * @brief Declares the probabilistic equality test based on random evaluation modulo a prime.
+ *
+ * Instead of expanding both expressions into sum-of-products form, RandomEvaluator evaluates
+ * them at random points modulo p = 2^61 - 1 (Schwartz–Zippel). Every variable gets an
+ * independent random value per trial; functions, quotients and powers that the exact mode
+ * keeps opaque become salted hashes of their argument values, i.e. uninterpreted symbols.
+ * One trial is a single walk over each tree, linear in the number of nodes.
+ *
+ * If two expressions evaluate differently in any trial they are certainly different (also
+ * for the exact mode). If all trials agree they are equal with probability at least
+ * 1 - (d/p)^trials, where d is the total degree of the expressions, as long as the integer
+ * coefficients of their difference are not multiples of p. Powers are evaluated without the
+ * expansion limits of EqualityChecker, so x^20 and x^10*x^10 compare equal here.
+ *
+ * Large coefficients can break that condition: p and 0, 2^60*2*x and x, or x^e and
+ * x^(e mod (p-1)) for an exponent e >= p-1, agree at every point, although no literal needs
+ * to reach p. The walk therefore carries, for every subtree, an upper bound on the sum of
+ * the absolute values of the coefficients it expands to (through + - * and constant powers;
+ * opaque parts count as one symbol). Once a bound reaches 2^60, a coefficient of the
+ * difference may be a multiple of p, and compare() decides the pair with the exact mode,
+ * returning Equal or Different instead of ProbablyEqual.
+ *
+ * Whether an exponent is a non-negative integer constant is decided in the same walk, never
+ * by standardizing it: literals are folded through + - * ^ bottom-up, and every subtree is
+ * also evaluated at a second independent point, so an exponent such as y-y+2 that is
+ * constant only after cancellation is recognized by having the same value at both points.
+ */
+#ifndef RANDOMEVALUATOR_H
+#define RANDOMEVALUATOR_H
+
+#include "AST.h"
+#include "AstArena.h"
+#include <cstdint>
+#include <memory>
+
+// 概率判等的结论
+enum class EqualityVerdict {
+    Different,     // 某次取值不同，一定不相等
+    ProbablyEqual, // 所有取值都相同，以 1-ε 的概率相等
+    Equal          // 经过完全展开确认相等
+};
+
+class RandomEvaluator {
+public:
+    static constexpr std::uint64_t kPrime = (std::uint64_t(1) << 61) - 1;
+    static constexpr int kDefaultTrials = 8;
+    static constexpr std::uint64_t kDefaultSeed = 0x5eed5eed2024ULL;
+
+    explicit RandomEvaluator(int trials = kDefaultTrials, std::uint64_t seed = kDefaultSeed);
+
+    int trials() const { return trialCount; }
+
+    // 第 trial 次取值下表达式的值，结果在 [0, kPrime)
+    std::uint64_t evaluate(const ASTNode& node, int trial) const;
+    std::uint64_t evaluate(const AstArena& arena, NodeId node, int trial) const;
+
+    // 返回 Different 或 ProbablyEqual；系数的上界达到 2^60 时完全展开，返回 Different 或 Equal
+    EqualityVerdict compare(const std::shared_ptr<ASTNode>& expr1, const std::shared_ptr<ASTNode>& expr2) const;
+    EqualityVerdict compare(const AstArena& arena1, NodeId root1, const AstArena& arena2, NodeId root2) const;
+
+private:
+    int trialCount;
+    std::uint64_t seed;
+};
+
+#endif // RANDOMEVALUATOR_H
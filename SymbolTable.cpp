@@ -0,0 +1,217 @@
+/**
+ * @file SymbolTable.cpp
+ * @brief Implements interning and lazy text rendering of polynomial symbols.
+ */
+#include "SymbolTable.h"
+#include "AST.h"
+
+namespace {
+
+void encodePoly(std::vector<std::int64_t>& key, const TermList& poly) {
+    key.push_back(static_cast<std::int64_t>(poly.size()));
+    for (const auto& term : poly) {
+        term.coeff.encode(key);
+        key.push_back(static_cast<std::int64_t>(term.vars.size()));
+        key.insert(key.end(), term.vars.begin(), term.vars.end());
+    }
+}
+
+// 从键中解码出一个多项式，pos 指向其起始位置并前移
+TermList decodePoly(const std::vector<std::int64_t>& key, size_t& pos) {
+    TermList poly(static_cast<size_t>(key[pos++]));
+    for (auto& term : poly) {
+        term.coeff = Coefficient::decode(key, pos);
+        size_t count = static_cast<size_t>(key[pos++]);
+        term.vars.assign(key.begin() + pos, key.begin() + pos + count);
+        pos += count;
+    }
+    return poly;
+}
+
+// 对键中各操作数多项式里出现的每个符号调用 f（键从下标 2 起依次是操作数多项式）
+template <typename F>
+void forEachOperandSymbol(const std::vector<std::int64_t>& key, F&& f) {
+    size_t pos = 2;
+    while (pos < key.size()) {
+        for (const auto& term : decodePoly(key, pos)) {
+            for (SymbolId id : term.vars) f(id);
+        }
+    }
+}
+
+// 由内容哈希导出两个独立的非零坐标
+Fingerprint pointFor(std::size_t h) {
+    auto coordinate = [h](std::size_t seed) {
+        std::uint64_t r = static_cast<std::uint64_t>(hashMix(seed, h)) % Fingerprint::kPrime;
+        return r == 0 ? 1 : r;
+    };
+    return {coordinate(0x243f6a8885a308d3ULL), coordinate(0x13198a2e03707344ULL)};
+}
+
+// 规范多项式的指纹：各项系数与单项式指纹之积的和
+Fingerprint polyFingerprint(const TermList& poly) {
+    Fingerprint sum;
+    for (const auto& term : poly) sum += Fingerprint::term(term.coeff, term.value);
+    return sum;
+}
+
+// 整体的坐标取决于种类、函数类型和各操作数的指纹
+Fingerprint atomPoint(std::size_t kind, std::size_t funcType, const TermList& first, const TermList* second) {
+    std::size_t h = hashMix(kind, funcType);
+    Fingerprint f = polyFingerprint(first);
+    h = hashMix(hashMix(h, f.a), f.b);
+    if (second) {
+        f = polyFingerprint(*second);
+        h = hashMix(hashMix(h, f.a), f.b);
+    }
+    return pointFor(h);
+}
+
+const char* funcName(TokenType funcType) {
+    switch (funcType) {
+        case TokenType::SIN: return "sin";
+        case TokenType::COS: return "cos";
+        case TokenType::TAN: return "tan";
+        case TokenType::COT: return "cot";
+        case TokenType::LN: return "ln";
+        case TokenType::SQRT: return "sqrt";
+        default: return "unknown_func";
+    }
+}
+
+} // namespace
+
+SymbolTable& SymbolTable::global() {
+    static SymbolTable table;
+    return table;
+}
+
+size_t SymbolTable::AtomKeyHash::operator()(const std::vector<std::int64_t>& key) const {
+    std::uint64_t h = 0x9e3779b97f4a7c15ULL ^ key.size();
+    for (std::int64_t v : key) {
+        h ^= static_cast<std::uint64_t>(v) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    }
+    return static_cast<size_t>(h);
+}
+
+SymbolTable::Symbol& SymbolTable::at(SymbolId id) {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return symbols[id];
+}
+
+Fingerprint SymbolTable::fingerprint(SymbolId id) {
+    return at(id).point;
+}
+
+size_t SymbolTable::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return symbols.size();
+}
+
+SymbolId SymbolTable::variable(std::string_view name, Fingerprint* point) {
+    std::string key(name);
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = variables.find(key);
+        if (it != variables.end()) {
+            if (point) *point = symbols[it->second].point;
+            return it->second;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto inserted = variables.emplace(std::move(key), static_cast<SymbolId>(symbols.size()));
+    if (inserted.second) {
+        Symbol& symbol = symbols.emplace_back();
+        symbol.text = inserted.first->first;
+        symbol.point = pointFor(hashText(symbol.text));
+    }
+    if (point) *point = symbols[inserted.first->second].point;
+    return inserted.first->second;
+}
+
+SymbolId SymbolTable::intern(std::vector<std::int64_t> key, const Fingerprint& point) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = atoms.find(key);
+        if (it != atoms.end()) return it->second;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto inserted = atoms.emplace(std::move(key), static_cast<SymbolId>(symbols.size()));
+    if (inserted.second) {
+        Symbol& symbol = symbols.emplace_back();
+        symbol.key = &inserted.first->first;
+        symbol.point = point;
+    }
+    return inserted.first->second;
+}
+
+SymbolId SymbolTable::function(TokenType funcType, const TermList& arg, Fingerprint* point) {
+    std::vector<std::int64_t> key = {static_cast<std::int64_t>(Kind::Function), static_cast<std::int64_t>(funcType)};
+    encodePoly(key, arg);
+    Fingerprint p = atomPoint(size_t(Kind::Function), size_t(funcType), arg, nullptr);
+    if (point) *point = p;
+    return intern(std::move(key), p);
+}
+
+SymbolId SymbolTable::quotient(const TermList& numerator, const TermList& denominator, Fingerprint* point) {
+    std::vector<std::int64_t> key = {static_cast<std::int64_t>(Kind::Quotient), 0};
+    encodePoly(key, numerator);
+    encodePoly(key, denominator);
+    Fingerprint p = atomPoint(size_t(Kind::Quotient), 0, numerator, &denominator);
+    if (point) *point = p;
+    return intern(std::move(key), p);
+}
+
+SymbolId SymbolTable::power(const TermList& base, const TermList& exponent, Fingerprint* point) {
+    std::vector<std::int64_t> key = {static_cast<std::int64_t>(Kind::Power), 0};
+    encodePoly(key, base);
+    encodePoly(key, exponent);
+    Fingerprint p = atomPoint(size_t(Kind::Power), 0, base, &exponent);
+    if (point) *point = p;
+    return intern(std::move(key), p);
+}
+
+std::string SymbolTable::render(const std::vector<std::int64_t>& key) {
+    size_t pos = 2;
+    TermList first = decodePoly(key, pos);
+    switch (static_cast<Kind>(key[0])) {
+        case Kind::Function:
+            return std::string(funcName(static_cast<TokenType>(key[1]))) + "(" + polyToString(first) + ")";
+        case Kind::Quotient:
+            return "(" + polyToString(first) + ")/(" + polyToString(decodePoly(key, pos)) + ")";
+        case Kind::Power:
+            return "(" + polyToString(first) + ")^(" + polyToString(decodePoly(key, pos)) + ")";
+        default:
+            return "?";
+    }
+}
+
+const std::string& SymbolTable::name(SymbolId id) {
+    Symbol& symbol = at(id);
+    // 变量的文本在驻留时已确定；整体只在第一次需要时生成，之后复用
+    if (symbol.key && !symbol.ready.load(std::memory_order_acquire)) {
+        renderNested(id);
+    }
+    return symbol.text;
+}
+
+void SymbolTable::renderNested(SymbolId id) {
+    // 操作数先于外层生成，render() 中的 polyToString 取名字时都已就绪，不会再递归
+    std::vector<SymbolId> pending{id};
+    while (!pending.empty()) {
+        Symbol& symbol = at(pending.back());
+        if (symbol.ready.load(std::memory_order_acquire)) {
+            pending.pop_back();
+            continue;
+        }
+        size_t before = pending.size();
+        forEachOperandSymbol(*symbol.key, [&](SymbolId operand) {
+            Symbol& inner = at(operand);
+            if (inner.key && !inner.ready.load(std::memory_order_acquire)) pending.push_back(operand);
+        });
+        if (pending.size() != before) continue;
+        std::call_once(symbol.rendered, [&] { symbol.text = render(*symbol.key); });
+        symbol.ready.store(true, std::memory_order_release);
+        pending.pop_back();
+    }
+}
@@ -0,0 +1,78 @@
+/**
+ * @file SymbolTable.h
+ * @brief Declares the process-wide interner for polynomial symbols.
+ *
+ * Variables and opaque sub-expressions (a function applied to a polynomial, a quotient of two
+ * polynomials, or a power that is not expanded) are mapped to small integer SymbolIds.
+ * Opaque atoms are identified structurally by their operator and the canonical (sorted,
+ * merged) polynomials of their operands, so equal atoms get the same ID without building
+ * any text. The text of a symbol is rendered lazily, once, the first time name() is asked.
+ * Nested atoms are rendered innermost first from an explicit work list, so deeply nested
+ * sin(sin(...)) chains do not recurse through name() and polyToString().
+ * Every symbol also gets its Fingerprint coordinates when it is interned, derived from its
+ * name or from its kind and its operands' fingerprints (see Fingerprint.h).
+ *
+ * The table is shared by all threads and internally synchronized. IDs are never freed.
+ */
+#ifndef SYMBOLTABLE_H
+#define SYMBOLTABLE_H
+
+#include "Lexer.h"
+#include "Polynomial.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class SymbolTable {
+public:
+    static SymbolTable& global();
+
+    // point 非空时同时写入符号的坐标，省去再调用一次 fingerprint()
+    SymbolId variable(std::string_view name, Fingerprint* point = nullptr);
+    // 以下参数必须是已经 sortAndMerge 过的规范多项式
+    SymbolId function(TokenType funcType, const TermList& arg, Fingerprint* point = nullptr);
+    SymbolId quotient(const TermList& numerator, const TermList& denominator, Fingerprint* point = nullptr);
+    SymbolId power(const TermList& base, const TermList& exponent, Fingerprint* point = nullptr);
+
+    // 符号的文本形式，如 "x"、"sin(xx)"、"(x)/(y)"
+    const std::string& name(SymbolId id);
+    // 符号在两个取值点上的坐标（非零），只取决于符号的内容
+    Fingerprint fingerprint(SymbolId id);
+    size_t size() const;
+
+private:
+    enum class Kind : std::uint8_t { Variable, Function, Quotient, Power };
+
+    // 结构化键：[kind, funcType, 各操作数多项式的编码...]
+    struct AtomKeyHash {
+        size_t operator()(const std::vector<std::int64_t>& key) const;
+    };
+    using AtomMap = std::unordered_map<std::vector<std::int64_t>, SymbolId, AtomKeyHash>;
+
+    struct Symbol {
+        const std::vector<std::int64_t>* key = nullptr; // 指向 atoms 中的键，变量为空
+        std::string text;
+        std::once_flag rendered;
+        std::atomic<bool> ready{false}; // text 已生成（变量不使用）
+        Fingerprint point;              // 驻留时确定，之后不变
+    };
+
+    mutable std::shared_mutex mutex;
+    std::deque<Symbol> symbols; // deque 保证扩容时元素地址不变
+    std::unordered_map<std::string, SymbolId> variables;
+    AtomMap atoms;
+
+    SymbolId intern(std::vector<std::int64_t> key, const Fingerprint& point);
+    Symbol& at(SymbolId id);
+    std::string render(const std::vector<std::int64_t>& key);
+    // 按从内到外的顺序生成 id 及其所有未生成的操作数的文本
+    void renderNested(SymbolId id);
+};
+
+#endif // SYMBOLTABLE_H
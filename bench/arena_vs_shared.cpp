@@ -0,0 +1,130 @@
+/**
+ * @file arena_vs_shared.cpp
+ * @brief Benchmark: shared_ptr AST vs AstArena for parse and parse+standardize.
+ *
+ * Reports heap allocations per expression and expressions per second for both
+ * representations on the same pre-tokenized corpus (random expressions from
+ * ExpressionGenerator plus the pairs in test.txt).
+ *
+ * Build (from the project root):
+ *   make bench/arena_vs_shared
+ * Run:
+ *   ./bench/arena_vs_shared [expressions] [rounds]
+ */
+#include "Lexer.h"
+#include "Parser.h"
+#include "AstArena.h"
+#include "EqualityChecker.h"
+#include "PerfStats.h"
+#include "exam.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+// 堆分配次数由 CountingNew.cpp 的 operator new 统计（只在计数时开启，Makefile 把它链接进本程序）
+static size_t allocationCount()
+{
+    return PerfStats::thisThread().allocations;
+}
+
+using Clock = std::chrono::steady_clock;
+
+struct Result
+{
+    double allocsPerExpr;
+    double exprsPerSec;
+};
+
+template <typename Fn>
+static Result measure(const std::vector<TokenBuffer> &corpus, int rounds, Fn &&fn)
+{
+    // 预热一次，使 arena 等复用缓冲区达到稳定容量
+    for (const auto &tokens : corpus)
+        fn(tokens);
+
+    // 计数单独跑一趟，计时的几趟不开统计
+    PerfStats::setEnabled(true);
+    size_t before = allocationCount();
+    for (const auto &tokens : corpus)
+        fn(tokens);
+    size_t allocations = allocationCount() - before;
+    PerfStats::setEnabled(false);
+
+    auto start = Clock::now();
+    for (int r = 0; r < rounds; ++r)
+        for (const auto &tokens : corpus)
+            fn(tokens);
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    double total = double(corpus.size()) * rounds;
+    return {double(allocations) / corpus.size(), total / seconds};
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? std::atoi(argv[1]) : 2000;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    // TokenBuffer 引用这些字符串，exprs 在整个测量期间保持不变
+    std::vector<std::string> exprs;
+    ExpressionGenerator generator;
+    for (int i = 0; i < count; ++i)
+        exprs.push_back(generator.generateExpression(0, 3 + i % 4));
+    std::ifstream pairs("test.txt");
+    std::string line;
+    while (std::getline(pairs, line))
+    {
+        size_t comma = line.find(',');
+        if (comma == std::string::npos)
+            continue;
+        exprs.push_back(line.substr(0, comma));
+        exprs.push_back(line.substr(comma + 1));
+    }
+
+    // 只保留能被完整处理的表达式，且词法分析不计入测量
+    std::vector<TokenBuffer> corpus;
+    for (const auto &expr : exprs)
+    {
+        try
+        {
+            Lexer lexer(expr);
+            auto tokens = lexer.tokenize();
+            Parser parser(tokens);
+            EqualityChecker::standardize(parser.parse());
+            corpus.push_back(std::move(tokens));
+        }
+        catch (const std::exception &)
+        {
+        }
+    }
+
+    size_t sink = 0;
+    Result sharedParse = measure(corpus, rounds, [&](const TokenBuffer &tokens)
+                                 {
+        Parser parser(tokens);
+        sink += parser.parse() != nullptr; });
+    AstArena arena;
+    Result arenaParse = measure(corpus, rounds, [&](const TokenBuffer &tokens)
+                                {
+        arena.clear();
+        Parser parser(tokens);
+        sink += parser.parse(arena); });
+    Result sharedFull = measure(corpus, rounds, [&](const TokenBuffer &tokens)
+                                {
+        Parser parser(tokens);
+        sink += EqualityChecker::standardize(parser.parse()).size(); });
+    Result arenaFull = measure(corpus, rounds, [&](const TokenBuffer &tokens)
+                               {
+        arena.clear();
+        Parser parser(tokens);
+        NodeId root = parser.parse(arena);
+        sink += EqualityChecker::standardize(arena, root).size(); });
+
+    std::printf("corpus: %zu expressions x %d rounds\n", corpus.size(), rounds);
+    std::printf("%-28s %16s %16s\n", "", "allocs/expr", "exprs/sec");
+    std::printf("%-28s %16.2f %16.0f\n", "shared_ptr parse", sharedParse.allocsPerExpr, sharedParse.exprsPerSec);
+    std::printf("%-28s %16.2f %16.0f\n", "arena parse", arenaParse.allocsPerExpr, arenaParse.exprsPerSec);
+    std::printf("%-28s %16.2f %16.0f\n", "shared_ptr parse+standardize", sharedFull.allocsPerExpr, sharedFull.exprsPerSec);
+    std::printf("%-28s %16.2f %16.0f\n", "arena parse+standardize", arenaFull.allocsPerExpr, arenaFull.exprsPerSec);
+    return sink == 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file batch_eval.cpp
+ * @brief Benchmark: BytecodeProgram::evaluateBatch against the scalar VM, plus accuracy check.
+ *
+ * For each expression the scalar VM is called once per point, and evaluateBatch runs over
+ * struct-of-arrays columns (one array per variable). Throughput is reported in Mpoints/s and
+ * as GB/s of column data read plus results written, next to a plain memcpy of the same bytes,
+ * which is the ceiling for memory-bound expressions. The last column is the largest error of
+ * the batch result against the scalar one (relative, or absolute when |value| < 1).
+ *
+ * Build (from the project root; the Makefile compiles BytecodeBatch.cpp with -O3):
+ *   make bench/batch_eval
+ * Run:
+ *   ./bench/batch_eval
+ */
+#include "Bytecode.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+static double seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void run(const char *label, const std::string &text, double lo, double hi, size_t points, int rounds)
+{
+    Lexer lexer(text);
+    TokenBuffer tokens = lexer.tokenize();
+    Parser parser(tokens);
+    auto ast = parser.parse();
+    BytecodeProgram program = BytecodeCompiler::compile(*ast);
+
+    size_t vars = program.slotNames().size();
+    std::mt19937_64 rng(2024);
+    std::uniform_real_distribution<double> dist(lo, hi);
+    std::vector<std::vector<double>> columns(vars, std::vector<double>(points));
+    std::vector<const double *> columnPtrs;
+    for (auto &column : columns)
+    {
+        for (double &v : column)
+            v = dist(rng);
+        columnPtrs.push_back(column.data());
+    }
+    std::vector<double> scalar(points), batch(points);
+
+    std::vector<double> slots(vars), stack(program.maxStackDepth());
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r)
+    {
+        for (size_t i = 0; i < points; ++i)
+        {
+            for (size_t s = 0; s < vars; ++s)
+                slots[s] = columns[s][i];
+            scalar[i] = program.evaluate(slots.data(), stack.data());
+        }
+    }
+    double scalarSec = seconds(start) / rounds;
+
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r)
+        program.evaluateBatch(columnPtrs.data(), points, batch.data());
+    double batchSec = seconds(start) / rounds;
+
+    // 同样字节数的 memcpy：读 vars 列、写一列
+    std::vector<double> sink(points);
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r)
+    {
+        for (size_t s = 0; s < vars; ++s)
+            std::memcpy(sink.data(), columns[s].data(), points * sizeof(double));
+    }
+    double copySec = seconds(start) / rounds;
+
+    double maxError = 0;
+    for (size_t i = 0; i < points; ++i)
+    {
+        double diff = std::fabs(batch[i] - scalar[i]);
+        if (std::isnan(batch[i]) != std::isnan(scalar[i]))
+            diff = INFINITY;
+        else if (std::isnan(batch[i]))
+            diff = 0;
+        maxError = std::max(maxError, diff / std::max(1.0, std::fabs(scalar[i])));
+    }
+
+    double bytes = double(points) * (vars + 1) * sizeof(double);
+    std::printf("%-8s %10.1f %10.1f %7.1fx %9.2f %9.2f %10.2e\n", label, points / scalarSec / 1e6,
+                points / batchSec / 1e6, scalarSec / batchSec, bytes / batchSec / 1e9,
+                bytes * vars / (vars + 1) * 2 / copySec / 1e9, maxError);
+}
+
+int main()
+{
+    // 4M 个点，每列 32 MB，超出缓存，简单表达式受内存带宽限制
+    const size_t points = 1 << 22;
+    std::printf("%-8s %10s %10s %8s %9s %9s %10s\n", "expr", "vm Mpt/s", "batch", "speedup", "GB/s", "memcpy", "max err");
+    run("linear", "3x + 2y - z + 7", -10, 10, points, 5);
+    run("poly", "3x^2 + 2xy - 5y + 7", -10, 10, points, 5);
+    run("sqrt", "sqrt(x*x + y*y + z*z)", -10, 10, points, 5);
+    run("sin", "sin(x)", -100, 100, points, 5);
+    run("cos", "cos(x)", -1e6, 1e6, points, 5);
+    run("tan", "tan(x)", -10, 10, points, 5);
+    run("cot", "cot(x)", -10, 10, points, 5);
+    run("ln", "ln(x)", 1e-300, 1e300, points, 5);
+    run("ln01", "ln(x)", 0, 2, points, 5);
+    run("mixed", "ln(x + 11) * sqrt(y + 10) / (x^3 - 2y + 1000) + sin(x*y)", -10, 10, points, 3);
+    run("edge", "sqrt(x) + ln(y) + sin(10000000z)", -1, 1, points, 3);
+    return 0;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file batch_throughput.cpp
+ * @brief Benchmark: BatchRunner pairs per second against the number of worker threads.
+ *
+ * Builds a batch by repeating the pairs of test.txt with the variables renamed per copy,
+ * so the symbol table keeps growing as in a real workload, then runs the batch with
+ * 1, 2, 4, ... threads up to twice the hardware thread count.
+ *
+ * Build (from the project root):
+ *   make bench/batch_throughput
+ * Run:
+ *   ./bench/batch_throughput [pairs]
+ */
+#include "BatchRunner.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+
+static std::string rename(const std::string &text, size_t copy)
+{
+    // 把变量 x/y/z 换成随副本变化的字母，其余字符不变
+    std::string out = text;
+    for (char &c : out)
+    {
+        if (c == 'x' || c == 'y' || c == 'z')
+            c = char('a' + (c - 'x' + copy) % 3 * 8 % 26);
+    }
+    return out;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t total = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    std::ifstream in("test.txt");
+    std::vector<ExpressionPair> seed = BatchRunner::readPairs(in);
+    if (seed.empty())
+    {
+        std::fprintf(stderr, "run from the project root (test.txt not found)\n");
+        return 1;
+    }
+    std::vector<ExpressionPair> pairs;
+    pairs.reserve(total);
+    for (size_t i = 0; i < total; ++i)
+    {
+        const ExpressionPair &p = seed[i % seed.size()];
+        size_t copy = i / seed.size();
+        pairs.push_back({i + 1, rename(p.left, copy), rename(p.right, copy)});
+    }
+
+    unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("hardware threads: %u, pairs: %zu\n", hw, pairs.size());
+    std::printf("%-14s %8s %14s\n", "mode", "threads", "pairs/s");
+    for (auto mode : {BatchRunner::Mode::Exact, BatchRunner::Mode::Probabilistic})
+    {
+        BatchRunner runner(mode);
+        for (unsigned threads = 1; threads <= 2 * hw; threads *= 2)
+        {
+            auto start = std::chrono::steady_clock::now();
+            auto results = runner.run(pairs, threads);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::printf("%-14s %8u %14.0f\n", mode == BatchRunner::Mode::Exact ? "exact" : "probabilistic",
+                        threads, results.size() / seconds);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file canon_cache.cpp
+ * @brief Benchmark: canonical forms from a cold CanonCache against a warm, memory-mapped one.
+ *
+ * Generates a fixed-seed corpus of expressions (depth 6), then
+ *   cold   every expression misses, is parsed and standardized, and is inserted
+ *   save   writes the cache file
+ *   open   a new CanonCache maps the file (only the header is read)
+ *   warm   every expression is looked up in the mapping
+ * and checks that the warm lookups return exactly the strings computed cold.
+ *
+ * Build (from the project root):
+ *   make bench/canon_cache
+ * Run:
+ *   ./bench/canon_cache [expressions] [cache file]
+ */
+#include "AstArena.h"
+#include "CanonCache.h"
+#include "EqualityChecker.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "exam.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsed(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    std::string path = argc > 2 ? argv[2] : "bench/canon_cache.bin";
+    std::remove(path.c_str());
+
+    ExpressionGenerator generator(42);
+    std::vector<std::string> exprs;
+    exprs.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+        exprs.push_back(generator.generateExpression(0, 6));
+
+    std::vector<std::string> expected(count);
+    double coldSec, saveSec, openSec, warmSec;
+    size_t bad = 0;
+    {
+        CanonCache cache(path);
+        AstArena arena;
+        auto start = Clock::now();
+        for (size_t i = 0; i < count; ++i)
+        {
+            std::string_view canonical;
+            if (cache.lookup(exprs[i], canonical))
+            {
+                expected[i] = std::string(canonical);
+                continue;
+            }
+            arena.clear();
+            Lexer lexer(exprs[i]);
+            Parser parser(lexer);
+            NodeId root = parser.parse(arena);
+            expected[i] = EqualityChecker::getStandardizedString(arena, root);
+            cache.insert(exprs[i], expected[i]);
+        }
+        coldSec = elapsed(start);
+        start = Clock::now();
+        cache.save();
+        saveSec = elapsed(start);
+    }
+    {
+        auto start = Clock::now();
+        CanonCache cache(path);
+        openSec = elapsed(start);
+        start = Clock::now();
+        for (size_t i = 0; i < count; ++i)
+        {
+            std::string_view canonical;
+            if (!cache.lookup(exprs[i], canonical) || canonical != expected[i])
+                ++bad;
+        }
+        warmSec = elapsed(start);
+        std::printf("expressions: %zu, distinct: %zu\n", count, cache.mappedEntries());
+    }
+    std::remove(path.c_str());
+
+    std::printf("%-6s %12s %12s\n", "phase", "total ms", "ns/expr");
+    std::printf("%-6s %12.2f %12.1f\n", "cold", coldSec * 1e3, coldSec * 1e9 / count);
+    std::printf("%-6s %12.2f %12.1f\n", "save", saveSec * 1e3, saveSec * 1e9 / count);
+    std::printf("%-6s %12.3f %12s\n", "open", openSec * 1e3, "-");
+    std::printf("%-6s %12.2f %12.1f\n", "warm", warmSec * 1e3, warmSec * 1e9 / count);
+    if (bad)
+    {
+        std::fprintf(stderr, "%zu lookups missed or differed\n", bad);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file coefficient_cost.cpp
+ * @brief Benchmark: cost of the Coefficient small-number path against plain int.
+ *
+ * Runs the multiply-accumulate loop of the sparse product kernel (c[slot] += a[i] * b[j], with
+ * the slot coming from a precomputed index as the hash lookup does) and the negate loop of
+ * subtraction once with int and once with Coefficient, over values that stay in machine-word
+ * range, then over values that overflow 64 bits to show the spill cost.
+ *
+ * Build (from the project root):
+ *   make bench/coefficient_cost
+ * Run:
+ *   ./bench/coefficient_cost
+ */
+#include "Coefficient.h"
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+// 伪随机的目标槽位，模拟哈希索引的间接写入
+static std::vector<std::uint32_t> makeSlots(size_t count, size_t range)
+{
+    std::vector<std::uint32_t> slots(count);
+    std::uint64_t x = 88172645463325252ULL;
+    for (auto &slot : slots)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        slot = static_cast<std::uint32_t>(x % range);
+    }
+    return slots;
+}
+
+template <typename T>
+static double multiplyAccumulate(const std::vector<T> &a, const std::vector<T> &b, std::vector<T> &out)
+{
+    std::vector<std::uint32_t> slots = makeSlots(b.size(), out.size());
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < a.size(); ++i)
+        for (size_t j = 0; j < b.size(); ++j)
+            out[slots[j]] += a[i] * b[j];
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double negateAll(std::vector<int> &values)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < 1000; ++round)
+        for (auto &v : values)
+            v *= -1;
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double negateAll(std::vector<Coefficient> &values)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < 1000; ++round)
+        for (auto &v : values)
+            v.negate();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+    const size_t n = 2000;
+    std::vector<int> ai(n), bi(n), outi(4096, 0);
+    std::vector<Coefficient> ac(n), bc(n), outc(4096);
+    for (size_t i = 0; i < n; ++i)
+    {
+        ai[i] = int(i % 7) - 3;
+        bi[i] = int(i % 5) - 2;
+        ac[i] = ai[i];
+        bc[i] = bi[i];
+    }
+
+    double pairs = double(n) * n;
+    double tInt = multiplyAccumulate(ai, bi, outi);
+    double tCoeff = multiplyAccumulate(ac, bc, outc);
+    bool same = true;
+    for (size_t i = 0; i < outi.size(); ++i)
+        same = same && outc[i] == Coefficient(outi[i]);
+
+    std::printf("%-22s %12s %12s\n", "loop", "int ns/op", "coeff ns/op");
+    std::printf("%-22s %12.2f %12.2f%s\n", "multiply-accumulate", tInt / pairs * 1e9, tCoeff / pairs * 1e9,
+                same ? "" : "  (MISMATCH)");
+    std::printf("%-22s %12.2f %12.2f\n", "negate", negateAll(ai) / (n * 1000.0) * 1e9,
+                negateAll(ac) / (n * 1000.0) * 1e9);
+
+    // 超出 64 位后的代价（int 在这里早已溢出，只测 Coefficient）
+    std::vector<Coefficient> ab(200), bb(200), outb(256);
+    for (size_t i = 0; i < ab.size(); ++i)
+    {
+        ab[i] = Coefficient::fromString("12345678901234567890123");
+        bb[i] = Coefficient::fromString("98765432109876543210987");
+    }
+    double tBig = multiplyAccumulate(ab, bb, outb);
+    std::printf("%-22s %12s %12.2f\n", "multiply-acc (big)", "-", tBig / (200.0 * 200.0) * 1e9);
+    return 0;
+}
@@ -0,0 +1,203 @@
+/**
+ * @file deep_scaling.cpp
+ * @brief Benchmark: tree passes on very deep trees, 10^3 .. --max nodes, on the default stack.
+ *
+ * Shapes (every one is a single spine as deep as the tree is large):
+ *   sum      x+y+x+y+...        left-associative, so the left spine is n/2 deep
+ *   negate   -----...x
+ *   parens   ((((...x...))))    one node, n levels of parentheses (n counts tokens)
+ *   function sin cos sin ... x
+ *   power    x^x^...^x          right spine of unexpanded powers
+ *
+ * For each input it times, per node: parsing into a shared_ptr tree and freeing it,
+ * EqualityChecker::standardize on the tree and on an AstArena, areEqual of the tree with
+ * itself (memo counting and sameStructure included), RandomEvaluator::compare, and bytecode
+ * compilation. A flat ns/node column means linear time. Printing is checked only up to --print-max nodes because its output
+ * (two spaces of indentation per level) grows with n * depth. "function" and "power" intern
+ * one opaque atom per level in the process-wide SymbolTable, which is never freed, so they
+ * stop at --atom-max nodes.
+ *
+ * Everything runs on the main thread with the default stack size; before the passes were
+ * made non-recursive, the sum shape crashed at around 10^5 nodes.
+ *
+ * Build (from the project root):
+ *   make bench/deep_scaling
+ * Run:
+ *   ./bench/deep_scaling [--max nodes] [--atom-max nodes] [--print-max nodes]
+ */
+#include "Lexer.h"
+#include "Parser.h"
+#include "AstArena.h"
+#include "Bytecode.h"
+#include "EqualityChecker.h"
+#include "PolyArena.h"
+#include "RandomEvaluator.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <streambuf>
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsed(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// 丢弃输出、只计字节数的流缓冲区
+class CountingBuf : public std::streambuf
+{
+public:
+    size_t bytes = 0;
+
+protected:
+    std::streamsize xsputn(const char *, std::streamsize n) override
+    {
+        bytes += static_cast<size_t>(n);
+        return n;
+    }
+    int overflow(int c) override
+    {
+        ++bytes;
+        return c;
+    }
+};
+
+static std::string makeInput(const char *shape, size_t n)
+{
+    std::string text;
+    if (std::strcmp(shape, "sum") == 0)
+    {
+        text.reserve(n + 1);
+        text += 'x';
+        for (size_t i = 1; i + 1 < n; i += 2)
+            text += (i / 2) % 2 ? "+x" : "+y";
+    }
+    else if (std::strcmp(shape, "negate") == 0)
+        text = std::string(n - 1, '-') + "x";
+    else if (std::strcmp(shape, "parens") == 0)
+        text = std::string(n, '(') + "x" + std::string(n, ')');
+    else if (std::strcmp(shape, "function") == 0)
+    {
+        text.reserve(n * 4);
+        for (size_t i = 1; i < n; ++i)
+            text += i % 2 ? "sin " : "cos ";
+        text += "x";
+    }
+    else
+    {
+        text.reserve(n + 1);
+        text += 'x';
+        for (size_t i = 1; i + 1 < n; i += 2)
+            text += "^x";
+    }
+    return text;
+}
+
+static void runShape(const char *shape, size_t n, size_t printMax)
+{
+    // TokenBuffer 只引用源文本
+    std::string text = makeInput(shape, n);
+    TokenBuffer tokens = Lexer(text).tokenize();
+    double nodes = double(n);
+
+    auto start = Clock::now();
+    {
+        auto tree = Parser(tokens).parse();
+    }
+    double parseSec = elapsed(start);
+
+    auto tree = Parser(tokens).parse();
+    AstArena arena;
+    NodeId root = Parser(tokens).parse(arena);
+
+    double treeSec, arenaSec, equalSec, randomSec, compileSec;
+    size_t terms;
+    {
+        PolyArena polyArena;
+        start = Clock::now();
+        terms = EqualityChecker::standardize(tree).size();
+        treeSec = elapsed(start);
+    }
+    {
+        PolyArena polyArena;
+        start = Clock::now();
+        EqualityChecker::standardize(arena, root);
+        arenaSec = elapsed(start);
+    }
+    start = Clock::now();
+    if (!EqualityChecker::areEqual(tree, tree))
+        throw std::runtime_error(std::string(shape) + ": tree not equal to itself");
+    equalSec = elapsed(start);
+    start = Clock::now();
+    if (RandomEvaluator().compare(tree, tree) != EqualityVerdict::ProbablyEqual)
+        throw std::runtime_error(std::string(shape) + ": random evaluation differs from itself");
+    randomSec = elapsed(start);
+    start = Clock::now();
+    BytecodeProgram program = BytecodeCompiler::compile(*tree);
+    compileSec = elapsed(start);
+
+    size_t printed = 0;
+    if (n <= printMax)
+    {
+        CountingBuf buf;
+        std::ostream out(&buf);
+        tree->print(out);
+        printed = buf.bytes;
+    }
+
+    std::printf("%-8s %9zu %7zu %8.1f %8.1f %8.1f %8.1f", shape, n, terms, parseSec * 1e9 / nodes,
+                treeSec * 1e9 / nodes, arenaSec * 1e9 / nodes, equalSec * 1e9 / nodes);
+    std::printf(" %8.1f", randomSec * 1e9 / nodes);
+    std::printf(" %8.1f %12zu\n", compileSec * 1e9 / nodes, printed);
+    std::fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t maxNodes = 10000000;
+    size_t atomMax = 1000000;
+    size_t printMax = 10000;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--max") == 0 && i + 1 < argc)
+            maxNodes = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--atom-max") == 0 && i + 1 < argc)
+            atomMax = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--print-max") == 0 && i + 1 < argc)
+            printMax = std::strtoull(argv[++i], nullptr, 10);
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--max nodes] [--atom-max nodes] [--print-max nodes]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    const char *shapes[] = {"sum", "negate", "parens", "function", "power"};
+    auto makesAtoms = [](const char *shape) {
+        return std::strcmp(shape, "function") == 0 || std::strcmp(shape, "power") == 0;
+    };
+    std::printf("%-8s %9s %7s %8s %8s %8s %8s %8s %8s %12s\n", "shape", "nodes", "terms", "parse", "std", "std-flat",
+                "areEqual", "random", "compile", "print bytes");
+    std::printf("%-8s %9s %7s %8s %8s %8s %8s %8s %8s\n", "", "", "", "ns/node", "ns/node", "ns/node", "ns/node",
+                "ns/node", "ns/node");
+    try
+    {
+        for (size_t n = 1000; n <= maxNodes; n *= 10)
+        {
+            for (const char *shape : shapes)
+            {
+                if (!makesAtoms(shape) || n <= atomMax)
+                    runShape(shape, n, printMax);
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "benchmark failed: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,154 @@
+/**
+ * @file fingerprint.cpp
+ * @brief Benchmark: polynomial fingerprints against canonical strings.
+ *
+ * Generates a fixed-seed corpus of expressions (depth 5, so many of them repeat or are
+ * equal after standardization) and checks that two expressions have the same fingerprint
+ * exactly when they have the same canonical form. It then times
+ *   string       getStandardizedString per expression
+ *   fingerprint  getFingerprint per expression (no sorting, no text)
+ *   ==           Polynomial::operator== on neighbouring standardized polynomials
+ *   ==, equal    Polynomial::operator== of each polynomial with a copy of itself
+ * ==, equal compares every term, the others mostly stop at the fingerprint.
+ *
+ * It also checks pairs whose coefficients agree modulo 2^61-1 but differ, such as (2^61-1)x
+ * and 0: their fingerprints must differ. Pairs that reach the same large coefficients by
+ * different routes, such as (x+2^61)(x-2^61) and xx-2^122, must have the same fingerprint.
+ *
+ * Build (from the project root):
+ *   make bench/fingerprint
+ * Run:
+ *   ./bench/fingerprint [expressions]
+ */
+#include "AstArena.h"
+#include "EqualityChecker.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "exam.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_map>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsed(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static Fingerprint fingerprintOf(const char *text)
+{
+    AstArena arena;
+    TokenBuffer tokens = Lexer(text).tokenize();
+    NodeId root = Parser(tokens).parse(arena);
+    return EqualityChecker::getFingerprint(arena, root);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 50000;
+    if (count < 2)
+        count = 2;
+
+    ExpressionGenerator generator(42);
+    std::vector<AstArena> arenas(count);
+    std::vector<NodeId> roots(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::string text = generator.generateExpression(0, 5);
+        TokenBuffer tokens = Lexer(text).tokenize();
+        roots[i] = Parser(tokens).parse(arenas[i]);
+    }
+
+    std::vector<std::string> strings(count);
+    auto start = Clock::now();
+    for (size_t i = 0; i < count; ++i)
+        strings[i] = EqualityChecker::getStandardizedString(arenas[i], roots[i]);
+    double stringSec = elapsed(start);
+
+    std::vector<Fingerprint> prints(count);
+    start = Clock::now();
+    for (size_t i = 0; i < count; ++i)
+        prints[i] = EqualityChecker::getFingerprint(arenas[i], roots[i]);
+    double printSec = elapsed(start);
+
+    // 规范形式与指纹必须一一对应
+    std::unordered_map<std::string, Fingerprint> byString;
+    std::unordered_map<Fingerprint, std::string, FingerprintHash> byPrint;
+    size_t bad = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto s = byString.emplace(strings[i], prints[i]).first;
+        auto p = byPrint.emplace(prints[i], strings[i]).first;
+        if (s->second != prints[i] || p->second != strings[i])
+        {
+            if (bad++ < 5)
+                std::fprintf(stderr, "mismatch: \"%s\" has %s, \"%s\" has %s\n", strings[i].c_str(),
+                             prints[i].toString().c_str(), p->second.c_str(), s->second.toString().c_str());
+        }
+    }
+    std::printf("expressions: %zu, distinct canonical forms: %zu, distinct fingerprints: %zu\n", count,
+                byString.size(), byPrint.size());
+
+    std::vector<Polynomial> polys;
+    polys.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+        polys.push_back(EqualityChecker::standardize(arenas[i], roots[i]));
+    size_t equal = 0;
+    start = Clock::now();
+    for (size_t i = 0; i + 1 < count; ++i)
+        equal += polys[i] == polys[i + 1];
+    double neighbourSec = elapsed(start);
+    for (size_t i = 0; i + 1 < count; ++i)
+        equal -= strings[i] == strings[i + 1];
+    if (equal != 0)
+        ++bad;
+
+    std::vector<Polynomial> copies = polys;
+    size_t same = 0;
+    start = Clock::now();
+    for (size_t i = 0; i < count; ++i)
+        same += polys[i] == copies[i];
+    double selfSec = elapsed(start);
+    if (same != count)
+        ++bad;
+
+    // 模 p 相同的不同系数；相同的大系数由不同途径得到
+    const char *const distinctPairs[][2] = {
+        {"(2305843009213693951)x", "0"},
+        {"1152921504606846976x", "0-1152921504606846975x"},
+        {"sin(2305843009213693951x)", "sin(0)"},
+        {"2^61*x", "x"},
+        {"4611686018427387904x+y", "y"}};
+    const char *const equalPairs[][2] = {
+        {"2^70*x-2^70*x+5", "5"},
+        {"(x+2^61)(x-2^61)", "xx-2^122"},
+        {"(2305843009213693951+1)x-x", "2305843009213693951x"},
+        {"-(2^62*x)+2^62*y", "(0-2^62)*x+4611686018427387904*y"},
+        {"(2^40*x+1)^2", "1+2^41*x+2^80*xx"},
+        {"sin(2^64*x)-sin(18446744073709551616x)", "0"}};
+    size_t large = 0;
+    for (const auto &pair : distinctPairs)
+        large += fingerprintOf(pair[0]) == fingerprintOf(pair[1]);
+    for (const auto &pair : equalPairs)
+        large += fingerprintOf(pair[0]) != fingerprintOf(pair[1]);
+    if (large)
+    {
+        std::fprintf(stderr, "%zu large-coefficient pairs got the wrong fingerprint verdict\n", large);
+        bad += large;
+    }
+
+    std::printf("%-12s %12s %12s\n", "phase", "total ms", "ns/expr");
+    std::printf("%-12s %12.2f %12.1f\n", "string", stringSec * 1e3, stringSec * 1e9 / count);
+    std::printf("%-12s %12.2f %12.1f\n", "fingerprint", printSec * 1e3, printSec * 1e9 / count);
+    std::printf("%-12s %12.2f %12.1f\n", "==", neighbourSec * 1e3, neighbourSec * 1e9 / (count - 1));
+    std::printf("%-12s %12.2f %12.1f\n", "==, equal", selfSec * 1e3, selfSec * 1e9 / count);
+    if (bad)
+    {
+        std::fprintf(stderr, "%zu fingerprints disagreed with the canonical forms\n", bad);
+        return 1;
+    }
+    return 0;
+}
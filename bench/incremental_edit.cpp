@@ -0,0 +1,182 @@
+/**
+ * @file incremental_edit.cpp
+ * @brief Benchmark: per-keystroke cost of IncrementalAnalyzer::edit against a full analysis.
+ *
+ * First replays random edits (inserting operators, parentheses, digits, letters and parts
+ * of keywords, deleting and replacing short ranges) on fixed-seed expressions and checks
+ * after every edit that ok(), canonical(), fingerprint() and error() agree with analyzing
+ * the new text from scratch.
+ *
+ * Then, for sums of 10^2 .. --max random depth-3 summands, types "+x" into the middle of
+ * the text one character at a time and deletes it again, and reports the mean time per
+ * keystroke next to one full analysis (tokenize, parse, standardize) of the same text.
+ * The first edit in the middle ("jump") moves the gap buffers there from the end of the
+ * text, which takes time proportional to the distance, and is reported separately. The
+ * keystrokes after it lex and parse the same few tokens and summands at every size (the last
+ * two columns). Their time still depends on the coefficients those summands carry; a large
+ * coefficient already in the running sum is changed in place and costs only the limbs the
+ * carry reaches. canonical() is not part of the keystroke: it sorts every term.
+ *
+ * Build (from the project root):
+ *   make bench/incremental_edit
+ * Run:
+ *   ./bench/incremental_edit [--max summands] [--edits n]
+ */
+#include "AstArena.h"
+#include "EqualityChecker.h"
+#include "IncrementalAnalyzer.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "PolyArena.h"
+#include "exam.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsed(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// 完整分析：返回规范形式（print 非空时同时写入指纹），不能解析时返回空串并写入 error
+static std::string analyze(const std::string &text, std::string &error, Fingerprint *print = nullptr)
+{
+    error.clear();
+    try
+    {
+        TokenBuffer tokens = Lexer(text).tokenize();
+        AstArena arena;
+        NodeId root = Parser(tokens).parse(arena);
+        if (print)
+            *print = EqualityChecker::getFingerprint(arena, root);
+        return EqualityChecker::getStandardizedString(arena, root);
+    }
+    catch (const std::exception &err)
+    {
+        error = err.what();
+        return std::string();
+    }
+}
+
+static bool checkRandomEdits(size_t edits)
+{
+    static const char *const pieces[] = {"x", "y", "1", "23", "+", "-", "*", "^", "(", ")", " ", "s",
+                                         "in", "sin", "co", "sqrt", "ln", "t", "2x", ")(", "-(", "^2"};
+    ExpressionGenerator generator(7);
+    std::mt19937 rng(11);
+    size_t done = 0;
+    while (done < edits)
+    {
+        IncrementalAnalyzer analyzer(generator.generateExpression(0, 5) + " + " + generator.generateExpression(0, 5));
+        for (int step = 0; step < 50 && done < edits; ++step, ++done)
+        {
+            const std::string &text = analyzer.text();
+            size_t offset = rng() % (text.size() + 1);
+            size_t removed = std::min<size_t>(rng() % 4 == 0 ? rng() % 4 : 0, text.size() - offset);
+            const char *inserted = rng() % 5 == 0 ? "" : pieces[rng() % (sizeof(pieces) / sizeof(pieces[0]))];
+            if (text.size() > 400)
+            {
+                inserted = ""; // 只删不增，防止越改越长
+                removed = std::min<size_t>(8, text.size() - offset);
+            }
+            analyzer.edit(offset, removed, inserted);
+
+            std::string error;
+            Fingerprint print;
+            std::string expected = analyze(analyzer.text(), error, &print);
+            bool same = analyzer.ok() == error.empty() &&
+                        (analyzer.ok() ? analyzer.canonical() == expected && analyzer.fingerprint() == print
+                                       : analyzer.error() == error);
+            if (!same)
+            {
+                std::fprintf(stderr, "mismatch after edit %zu: \"%s\"\n  incremental: %s\n  full: %s\n", done,
+                             analyzer.text().c_str(), analyzer.ok() ? analyzer.canonical().c_str() : analyzer.error().c_str(),
+                             error.empty() ? expected.c_str() : error.c_str());
+                return false;
+            }
+        }
+    }
+    std::printf("random edits checked against full analysis: %zu\n\n", edits);
+    return true;
+}
+
+static void timeKeystrokes(size_t summands)
+{
+    ExpressionGenerator generator(42);
+    std::string text = generator.generateExpression(0, 3);
+    for (size_t i = 1; i < summands; ++i)
+        text += " + " + generator.generateExpression(0, 3);
+
+    std::string error;
+    auto start = Clock::now();
+    analyze(text, error);
+    double fullSec = elapsed(start);
+
+    IncrementalAnalyzer analyzer(text);
+    size_t middle = text.size() / 2;
+    while (middle < text.size() && text[middle] != ' ')
+        ++middle; // 在空白处开始输入
+    // 第一次在这里编辑时要把间隙从文本末尾移过来，单独计时
+    start = Clock::now();
+    analyzer.edit(middle, 0, "");
+    double jumpSec = elapsed(start);
+    const int rounds = 500;
+    size_t parsed = 0, lexed = 0, keys = 0;
+    start = Clock::now();
+    for (int r = 0; r < rounds; ++r)
+    {
+        analyzer.edit(middle, 0, "+");
+        analyzer.edit(middle + 1, 0, "x");
+        parsed += analyzer.lastEdit().summandsParsed;
+        lexed += analyzer.lastEdit().tokensLexed;
+        analyzer.edit(middle + 1, 1, "");
+        analyzer.edit(middle, 1, "");
+        keys += 4;
+    }
+    double editSec = elapsed(start) / keys;
+    if (!analyzer.ok() || analyzer.text() != text)
+        throw std::runtime_error("text or state changed after the edits");
+
+    std::printf("%9zu %10zu %12.1f %12.1f %12.2f %9.0fx %10zu %10zu\n", summands, text.size(), fullSec * 1e6,
+                jumpSec * 1e6, editSec * 1e6, fullSec / editSec, lexed / rounds, parsed / rounds);
+    std::fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t maxSummands = 100000;
+    size_t edits = 20000;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--max") == 0 && i + 1 < argc)
+            maxSummands = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--edits") == 0 && i + 1 < argc)
+            edits = std::strtoull(argv[++i], nullptr, 10);
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--max summands] [--edits n]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (!checkRandomEdits(edits))
+        return 1;
+    std::printf("%9s %10s %12s %12s %12s %10s %10s %10s\n", "summands", "bytes", "full us", "jump us", "edit us",
+                "speedup", "tokens", "summands");
+    std::printf("%9s %10s %12s %12s %12s %10s %10s %10s\n", "", "", "", "", "per key", "", "lexed", "parsed");
+    try
+    {
+        for (size_t n = 100; n <= maxSummands; n *= 10)
+            timeKeystrokes(n);
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "benchmark failed: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
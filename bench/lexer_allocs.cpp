@@ -0,0 +1,49 @@
+/**
+ * @file lexer_allocs.cpp
+ * @brief Benchmark: heap allocations and throughput of Lexer::tokenize on a large input.
+ *
+ * Builds an expression of the requested size (default 10 MB) by repeating the pairs in
+ * test.txt, then counts the allocations made by a single tokenize() call.
+ *
+ * Build (from the project root):
+ *   make bench/lexer_allocs
+ * Run:
+ *   ./bench/lexer_allocs [megabytes]
+ */
+#include "Lexer.h"
+#include "PerfStats.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char **argv)
+{
+    double megabytes = argc > 1 ? std::atof(argv[1]) : 10.0;
+    size_t target = static_cast<size_t>(megabytes * 1024 * 1024);
+
+    // 覆盖隐式乘法、函数、幂和括号的片段
+    const std::string pieces[] = {"sinxln(xx) + lnx^2sinx", "(1+sin(x^2))^3", "yx^(x+sinx^2)",
+                                  "x^2y + x * yx", "2x / y + 1", "(x * y) ^ (a + b)"};
+    std::string text;
+    text.reserve(target + 64);
+    for (size_t i = 0; text.size() < target; ++i)
+    {
+        if (i > 0)
+            text += " + ";
+        text += pieces[i % 6];
+    }
+
+    // 分配次数由 CountingNew.cpp 的 operator new 统计（Makefile 把它链接进本程序）
+    PerfStats::setEnabled(true);
+    size_t before = PerfStats::thisThread().allocations;
+    auto start = std::chrono::steady_clock::now();
+    Lexer lexer(text);
+    TokenBuffer tokens = lexer.tokenize();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    size_t allocations = PerfStats::thisThread().allocations - before;
+
+    std::printf("input: %.1f MB, tokens: %zu\n", text.size() / 1048576.0, tokens.size());
+    std::printf("allocations: %zu\n", allocations);
+    std::printf("throughput: %.1f MB/s\n", text.size() / 1048576.0 / seconds);
+    return 0;
+}
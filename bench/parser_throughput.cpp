@@ -0,0 +1,189 @@
+/**
+ * @file parser_throughput.cpp
+ * @brief Benchmark: parser throughput in tokens/second, and parsing of very deeply nested input.
+ *
+ * Part 1 parses fixed-seed ExpressionGenerator corpora (the same seeds as bench/suite) with
+ * each of the three builders: shared_ptr tree, AstArena and NodeFactory. The tokens are
+ * produced beforehand, so only parsing (and freeing the tree) is timed. Token and node counts
+ * come from PerfStats.
+ *
+ * Part 2 parses and frees inputs nested 10^3 .. --deep-max levels deep:
+ *   parens   ((((...x...))))
+ *   negate   -----...x
+ *   power    x^x^...^x          (right-associative, so the tree is a right spine)
+ *   function sin sin ... sin x
+ * Each one is parsed into both a shared_ptr tree and an AstArena.
+ *
+ * Build (from the project root):
+ *   make bench/parser_throughput
+ * Run:
+ *   ./bench/parser_throughput [--min-time seconds] [--deep-max levels]
+ */
+#include "Lexer.h"
+#include "Parser.h"
+#include "PerfStats.h"
+#include "exam.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsed(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// 防止被测结果被优化掉
+static volatile size_t gSink;
+
+// 重复整趟执行 pass 直到累计时间超过 minTime，返回每趟的平均秒数
+template <typename Pass>
+static double timePasses(Pass pass, double minTime)
+{
+    pass(); // 预热
+    size_t passes = 0;
+    auto start = Clock::now();
+    double total = 0;
+    do
+    {
+        pass();
+        ++passes;
+        total = elapsed(start);
+    } while (total < minTime);
+    return total / passes;
+}
+
+static void runCorpus(const char *name, std::uint32_t seed, int maxDepth, size_t count, double minTime)
+{
+    ExpressionGenerator generator(seed);
+    // TokenBuffer 只引用源文本，文本要在整个测试期间保留
+    std::vector<std::string> texts(count);
+    std::vector<TokenBuffer> tokens(count);
+    size_t tokenCount = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        texts[i] = generator.generateExpression(0, maxDepth);
+        tokens[i] = Lexer(texts[i]).tokenize();
+        tokenCount += tokens[i].size();
+    }
+
+    // 一趟带计数的解析，得到每个 Token 平均产生的节点数
+    PerfStats::setEnabled(true);
+    PerfStats::Request request;
+    for (const TokenBuffer &t : tokens)
+        Parser(t).parse();
+    PerfCounters counters = request.finish();
+    PerfStats::setEnabled(false);
+
+    double shared = timePasses([&] {
+        for (const TokenBuffer &t : tokens)
+            gSink = Parser(t).parse() != nullptr;
+    }, minTime);
+    AstArena arena;
+    double flat = timePasses([&] {
+        for (const TokenBuffer &t : tokens)
+        {
+            arena.clear();
+            gSink = Parser(t).parse(arena);
+        }
+    }, minTime);
+    double factory = timePasses([&] {
+        for (const TokenBuffer &t : tokens)
+        {
+            NodeFactory f;
+            gSink = Parser(t).parse(f) != nullptr;
+        }
+    }, minTime);
+
+    std::printf("%-8s %8zu %8.2f %14.2f %14.2f %14.2f\n", name, tokenCount,
+                double(counters.astNodes) / tokenCount, tokenCount / shared / 1e6, tokenCount / flat / 1e6,
+                tokenCount / factory / 1e6);
+}
+
+static std::string deepInput(const char *shape, size_t levels)
+{
+    std::string text;
+    if (std::strcmp(shape, "parens") == 0)
+        text = std::string(levels, '(') + "x" + std::string(levels, ')');
+    else if (std::strcmp(shape, "negate") == 0)
+        text = std::string(levels, '-') + "x";
+    else if (std::strcmp(shape, "power") == 0)
+    {
+        text.reserve(levels * 2 + 1);
+        text += "x";
+        for (size_t i = 0; i < levels; ++i)
+            text += "^x";
+    }
+    else
+    {
+        text.reserve(levels * 4 + 1);
+        for (size_t i = 0; i < levels; ++i)
+            text += "sin ";
+        text += "x";
+    }
+    return text;
+}
+
+static void runDeep(size_t maxLevels)
+{
+    const char *shapes[] = {"parens", "negate", "power", "function"};
+    std::printf("\n%-8s %9s %9s %12s %12s\n", "shape", "levels", "tokens", "tree Mtok/s", "arena Mtok/s");
+    for (size_t levels = 1000; levels <= maxLevels; levels *= 10)
+    {
+        for (const char *shape : shapes)
+        {
+            std::string text = deepInput(shape, levels);
+            TokenBuffer tokens = Lexer(text).tokenize();
+            // 包含释放整棵树的时间
+            auto start = Clock::now();
+            {
+                auto tree = Parser(tokens).parse();
+                gSink = tree != nullptr;
+            }
+            double treeSec = elapsed(start);
+            AstArena arena;
+            start = Clock::now();
+            gSink = Parser(tokens).parse(arena);
+            double arenaSec = elapsed(start);
+            std::printf("%-8s %9zu %9zu %12.2f %12.2f\n", shape, levels, tokens.size(),
+                        tokens.size() / treeSec / 1e6, tokens.size() / arenaSec / 1e6);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    double minTime = 0.3;
+    size_t deepMax = 1000000;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+            minTime = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--deep-max") == 0 && i + 1 < argc)
+            deepMax = std::strtoull(argv[++i], nullptr, 10);
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--min-time seconds] [--deep-max levels]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    try
+    {
+        std::printf("%-8s %8s %8s %14s %14s %14s\n", "corpus", "tokens", "nodes/t", "tree Mtok/s", "arena Mtok/s",
+                    "factory Mtok/s");
+        runCorpus("depth3", 1001, 3, 4000, minTime);
+        runCorpus("depth6", 1002, 6, 2000, minTime);
+        runCorpus("depth12", 1004, 12, 200, minTime);
+        runDeep(deepMax);
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "benchmark failed: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file product_scaling.cpp
+ * @brief Benchmark: standardize() time on products of two large sums and on cubes of sums.
+ *
+ * The left factor is a sum of k monomials "p*q" over lowercase letters and the right
+ * factor a sum of k monomials "P*Q" over uppercase letters, so the product has k*k
+ * distinct terms. The cube (s)^3 exercises the expansion path, where many products
+ * collapse into like terms.
+ *
+ * Build (from the project root):
+ *   make bench/product_scaling
+ * Run:
+ *   ./bench/product_scaling
+ */
+#include "Lexer.h"
+#include "Parser.h"
+#include "EqualityChecker.h"
+#include <chrono>
+#include <cstdio>
+
+static std::string makeSum(size_t k, char base)
+{
+    std::string text = "(";
+    for (size_t i = 0; i < k; ++i)
+    {
+        if (i > 0)
+            text += " + ";
+        text += char(base + i % 26);
+        text += '*';
+        text += char(base + (i / 26) % 26);
+    }
+    return text + ")";
+}
+
+static void run(const char *label, size_t k, const std::string &text)
+{
+    Lexer lexer(text);
+    TokenBuffer tokens = lexer.tokenize();
+    Parser parser(tokens);
+    auto ast = parser.parse();
+
+    auto start = std::chrono::steady_clock::now();
+    auto poly = EqualityChecker::standardize(ast);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-10s %6zu %10zu %12.2f\n", label, k, poly.size(), seconds * 1e3);
+}
+
+int main()
+{
+    std::printf("%-10s %6s %10s %12s\n", "shape", "k", "terms", "ms");
+    for (size_t k : {100, 200, 400})
+        run("product", k, makeSum(k, 'a') + makeSum(k, 'A'));
+    for (size_t k : {10, 20, 40})
+        run("cube", k, makeSum(k, 'a') + "^3");
+    return 0;
+}
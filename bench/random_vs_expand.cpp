@@ -0,0 +1,148 @@
+/**
+ * @file random_vs_expand.cpp
+ * @brief Benchmark: probabilistic equality (RandomEvaluator) against full expansion.
+ *
+ * Compares (a1+b1)(a2+b2)...(ak+bk) with the same product written in reverse order. Full
+ * expansion produces 2^k terms on each side; random evaluation walks each tree once per
+ * trial, so its cost grows only with k.
+ *
+ * Then checks that powers whose exponent is constant only after folding or cancellation
+ * (x^(2*3-4), x^(y-y+2)) get the same verdict as the exact mode, and so do pairs that agree
+ * modulo p only because of a large coefficient, such as (2^61-1)x and 0, x^(2^61-1) and x,
+ * or 2^60*2*x and x, where every literal is below p (these fall back to the exact mode). It then times the comparison
+ * of power towers x^x^...^x (n levels) with themselves and with y^x^...^x. Random
+ * evaluation must not expand exponents, so the time per node has to stay flat; the
+ * program fails if it grows more than 4 times from the smallest to the largest tower.
+ *
+ * Build (from the project root):
+ *   make bench/random_vs_expand
+ * Run:
+ *   ./bench/random_vs_expand
+ */
+#include "Lexer.h"
+#include "Parser.h"
+#include "EqualityChecker.h"
+#include "RandomEvaluator.h"
+#include <chrono>
+#include <cstdio>
+
+static std::string factor(size_t i)
+{
+    // 变量名用 '*' 隔开的字母组合，避免拼出关键字
+    std::string a(1, char('a' + i % 26));
+    std::string b(1, char('a' + (i + 7) % 26));
+    return "(" + a + "*" + a + " + " + b + ")";
+}
+
+static std::shared_ptr<ASTNode> parseText(const std::string &text)
+{
+    Lexer lexer(text);
+    TokenBuffer tokens = lexer.tokenize();
+    Parser parser(tokens);
+    return parser.parse();
+}
+
+template <typename F>
+static double millis(F &&f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e3;
+}
+
+int main()
+{
+    std::printf("%4s %14s %14s %10s\n", "k", "expand ms", "random ms", "verdict");
+    RandomEvaluator evaluator;
+    for (size_t k : {4, 8, 12, 16, 18})
+    {
+        std::string forward, backward;
+        for (size_t i = 0; i < k; ++i)
+        {
+            forward += factor(i);
+            backward += factor(k - 1 - i);
+        }
+        auto left = parseText(forward);
+        auto right = parseText(backward);
+
+        bool exact = false;
+        double expandMs = millis([&] { exact = EqualityChecker::standardize(left) == EqualityChecker::standardize(right); });
+        EqualityVerdict verdict = EqualityVerdict::Different;
+        double randomMs = millis([&] { verdict = evaluator.compare(left, right); });
+        std::printf("%4zu %14.3f %14.3f %10s\n", k, expandMs, randomMs,
+                    verdict == EqualityVerdict::ProbablyEqual && exact ? "equal" : "MISMATCH");
+    }
+
+    // 指数的常数折叠与消去必须与完全展开的结论一致
+    const char *const exponents[][2] = {
+        {"x^(2*3-4)", "x*x"},         {"x^(y-y+2)", "x^2"},       {"x^(x-x)", "1"},
+        {"x^(sin(y)-sin(y)+3)", "x^3"}, {"x^2^2", "x^4"},          {"(x+1)^(y^0+1)", "(x+1)^2"},
+        {"x^(0-2)", "x^(1-3)"},       {"x^(0-2)", "x^2"},         {"x^y", "x^z"},
+        {"x^(y-y+1/2)", "x^(1/2)"},   {"0^(y-y)", "1"},           {"2^(x-x+3)", "8"}};
+    // 取模后才相同的常数：只有精确判等才能区分
+    const char *const wide[][2] = {
+        {"(2305843009213693951)x", "0"},
+        {"x^2305843009213693951", "x"},
+        {"(1152921504606846976+1152921504606846975)x", "0"},
+        {"2^100*x", "549755813888*x"},
+        {"3^(y-y+40)*x", "628450412988459046x"},
+        {"(2305843009213693951+1)x-x", "2305843009213693951x"},
+        {"x^(2305843009213693951-2)", "x^2305843009213693949"},
+        {"2^64", "18446744073709551616"},
+        {"(0-3)^41*x", "(0-36472996377170786403)x"},
+        // 字面量都小于 p，系数由未折叠的乘积变大
+        {"x*1152921504606846976*2", "x"},
+        {"(y-y+1152921504606846976)*2", "1"},
+        {"x^((y-y+1)*1152921504606846976*2)", "x"},
+        {"1152921504606846981x", "0-1152921504606846970x"}};
+    size_t wrong = 0;
+    auto check = [&](const char *const(&pair)[2]) {
+        auto left = parseText(pair[0]);
+        auto right = parseText(pair[1]);
+        bool exact = EqualityChecker::standardize(left) == EqualityChecker::standardize(right);
+        bool equal = evaluator.compare(left, right) != EqualityVerdict::Different;
+        if (exact != equal)
+        {
+            std::fprintf(stderr, "%s vs %s: exact %s, random %s\n", pair[0], pair[1], exact ? "equal" : "different",
+                         equal ? "equal" : "different");
+            ++wrong;
+        }
+    };
+    for (const auto &pair : exponents)
+        check(pair);
+    std::printf("\nexponent folding checks: %zu, mismatches: %zu\n", sizeof(exponents) / sizeof(exponents[0]), wrong);
+    size_t before = wrong;
+    for (const auto &pair : wide)
+        check(pair);
+    std::printf("large coefficients: %zu, mismatches: %zu\n\n", sizeof(wide) / sizeof(wide[0]), wrong - before);
+
+    std::printf("%8s %14s %14s %10s\n", "levels", "random ms", "ns/node", "verdict");
+    double first = 0, last = 0;
+    for (size_t n : {1000, 4000, 16000, 64000})
+    {
+        std::string tower = "x";
+        for (size_t i = 1; i < n; ++i)
+            tower += "^x";
+        std::string other = "y" + tower.substr(1);
+        auto left = parseText(tower);
+        auto same = parseText(tower);
+        auto right = parseText(other);
+
+        EqualityVerdict equal = EqualityVerdict::Different, different = EqualityVerdict::ProbablyEqual;
+        double ms = millis([&] {
+            equal = evaluator.compare(left, same);
+            different = evaluator.compare(left, right);
+        });
+        double perNode = ms * 1e6 / double(2 * n - 1);
+        bool ok = equal == EqualityVerdict::ProbablyEqual && different == EqualityVerdict::Different;
+        std::printf("%8zu %14.3f %14.1f %10s\n", n, ms, perNode, ok ? "ok" : "MISMATCH");
+        wrong += !ok;
+        (first == 0 ? first : last) = perNode;
+    }
+    if (last > 4 * first)
+    {
+        std::fprintf(stderr, "power towers: %.1f ns/node at the largest size, %.1f at the smallest\n", last, first);
+        ++wrong;
+    }
+    return wrong ? 1 : 0;
+}
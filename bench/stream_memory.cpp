@@ -0,0 +1,98 @@
+/**
+ * @file stream_memory.cpp
+ * @brief Benchmark: peak RSS of buffered vs streaming (pull-based) lexing + parsing.
+ *
+ * Each mode runs in a forked child so that its peak resident set size is measured in
+ * isolation. The buffered mode tokenizes the whole input into a TokenBuffer before
+ * parsing; the streaming mode lets Parser pull tokens from Lexer on demand. Both parse
+ * into an AstArena, so the difference is the materialized token sequence.
+ *
+ * Build (from the project root, POSIX only):
+ *   make bench/stream_memory
+ * Run:
+ *   ./bench/stream_memory [megabytes]      (default 100)
+ */
+#include "Lexer.h"
+#include "Parser.h"
+#include "AstArena.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static std::string makeInput(size_t target)
+{
+    // 长整数和空格让每字节对应的节点较少，Token 序列占内存的比例更明显
+    const std::string pieces[] = {"(12345678 + 87654321) * 11223344", "sin(98765432 x) - 55667788 y",
+                                  "(x + 44332211)^2", "ln(13572468) / 24681357"};
+    std::string text;
+    text.reserve(target + 64);
+    for (size_t i = 0; text.size() < target; ++i)
+    {
+        if (i > 0)
+            text += " + ";
+        text += pieces[i % 4];
+    }
+    return text;
+}
+
+static long peakRssKb()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss; // Linux 上单位为 KB
+}
+
+static void runMode(bool streaming, size_t target)
+{
+    std::string text = makeInput(target);
+    long baseline = peakRssKb();
+
+    auto start = std::chrono::steady_clock::now();
+    AstArena arena;
+    // 两种模式预留相同的节点容量（大于 Token 数），避免 arena 扩容的差异干扰比较
+    arena.reserve(text.size() / 3, 0);
+    size_t tokenCount = 0;
+    if (streaming)
+    {
+        Lexer lexer(text);
+        Parser parser(lexer);
+        parser.parse(arena);
+    }
+    else
+    {
+        Lexer lexer(text);
+        TokenBuffer tokens = lexer.tokenize();
+        tokenCount = tokens.size();
+        Parser parser(tokens);
+        parser.parse(arena);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%-10s input %.0f MB  nodes %zu  tokens held %zu  peak RSS %.0f MB (input only %.0f MB)  %.2f s\n",
+                streaming ? "streaming" : "buffered", text.size() / 1048576.0, arena.size(), tokenCount,
+                peakRssKb() / 1024.0, baseline / 1024.0, seconds);
+    std::fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+    double megabytes = argc > 1 ? std::atof(argv[1]) : 100.0;
+    size_t target = static_cast<size_t>(megabytes * 1024 * 1024);
+
+    for (bool streaming : {false, true})
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            runMode(streaming, target);
+            std::_Exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+    }
+    return 0;
+}
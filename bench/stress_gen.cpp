@@ -0,0 +1,64 @@
+/**
+ * @file stress_gen.cpp
+ * @brief Writes one size-targeted stress expression to stdout (ExpressionGenerator::generateSized).
+ *
+ * The expression is streamed with a 64 KB buffer, so multi-gigabyte inputs need no memory.
+ * Generation speed is reported on stderr, next to the recursive generateExpression for
+ * comparison.
+ *
+ * Build (from the project root):
+ *   make bench/stress_gen
+ * Run:
+ *   ./bench/stress_gen deep|wide|tower <size> [bytes|nodes] [seed] > expr.txt
+ */
+#include "exam.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        std::fprintf(stderr, "usage: %s deep|wide|tower <size> [bytes|nodes] [seed]\n", argv[0]);
+        return 2;
+    }
+    Shape shape;
+    if (std::strcmp(argv[1], "deep") == 0)
+        shape = Shape::Deep;
+    else if (std::strcmp(argv[1], "wide") == 0)
+        shape = Shape::Wide;
+    else if (std::strcmp(argv[1], "tower") == 0)
+        shape = Shape::Tower;
+    else
+    {
+        std::fprintf(stderr, "unknown shape: %s\n", argv[1]);
+        return 2;
+    }
+    size_t target = std::strtoull(argv[2], nullptr, 10);
+    SizeUnit unit = argc > 3 && std::strcmp(argv[3], "nodes") == 0 ? SizeUnit::Nodes : SizeUnit::Bytes;
+    std::uint32_t seed = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 1;
+
+    std::ios::sync_with_stdio(false);
+    ExpressionGenerator generator(seed);
+    auto start = std::chrono::steady_clock::now();
+    generator.generateSized(std::cout, target, shape, unit);
+    std::cout << '\n';
+    std::cout.flush();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::fprintf(stderr, "generateSized: %.3f s\n", sec);
+
+    // 同样数量的字节用递归版本（深度 12 的随机表达式）生成，作为对照
+    if (unit == SizeUnit::Bytes)
+    {
+        ExpressionGenerator recursive(seed);
+        size_t produced = 0;
+        start = std::chrono::steady_clock::now();
+        while (produced < target)
+            produced += recursive.generateExpression(0, 12).size();
+        sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::fprintf(stderr, "generateExpression (depth 12, same bytes): %.3f s\n", sec);
+    }
+    return 0;
+}
@@ -0,0 +1,298 @@
+/**
+ * @file suite.cpp
+ * @brief Reproducible benchmark suite: per-phase throughput and latency on fixed-seed corpora.
+ *
+ * Corpora come from ExpressionGenerator with fixed seeds at several depths, plus the
+ * generateEdgeCases() set, so every build measures exactly the same inputs. Each phase is
+ * measured on its own, with the inputs of the phase prepared beforehand:
+ *   tokenize     Lexer(text).tokenize()
+ *   parse        Parser(tokens).parse()
+ *   standardize  EqualityChecker::standardize(ast)
+ *   areEqual     EqualityChecker::areEqual(ast, separately parsed copy of the same text)
+ * Throughput comes from timing whole passes over the corpus (repeated until --min-time),
+ * latency percentiles from a separate pass that times every call on its own.
+ *
+ * Output is a text table by default, or JSON / CSV for tracking results between releases.
+ *
+ * Build (from the project root):
+ *   make bench/suite
+ * Run:
+ *   ./bench/suite [--format text|json|csv] [--out file] [--min-time seconds]
+ */
+#include "Lexer.h"
+#include "Parser.h"
+#include "EqualityChecker.h"
+#include "exam.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+struct Corpus
+{
+    std::string name;
+    std::uint32_t seed; // 0 表示不是随机生成的
+    int maxDepth;
+    std::vector<std::string> texts;
+};
+
+struct PhaseResult
+{
+    std::string corpus;
+    std::string phase;
+    size_t items = 0;
+    size_t bytes = 0;
+    size_t passes = 0;
+    double itemsPerSec = 0;
+    double mbPerSec = 0;
+    double p50 = 0, p90 = 0, p99 = 0, max = 0; // 单次调用耗时，ns
+};
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsed(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static std::vector<Corpus> buildCorpora()
+{
+    // 种子和规模固定；修改它们会使新旧结果不可比较
+    struct Spec
+    {
+        const char *name;
+        std::uint32_t seed;
+        int maxDepth;
+        size_t count;
+    };
+    const Spec specs[] = {
+        {"depth3", 1001, 3, 4000},
+        {"depth6", 1002, 6, 2000},
+        {"depth9", 1003, 9, 1000},
+        {"depth12", 1004, 12, 200},
+    };
+    std::vector<Corpus> corpora;
+    for (const Spec &spec : specs)
+    {
+        ExpressionGenerator generator(spec.seed);
+        Corpus corpus{spec.name, spec.seed, spec.maxDepth, {}};
+        for (size_t i = 0; i < spec.count; ++i)
+            corpus.texts.push_back(generator.generateExpression(0, spec.maxDepth));
+        corpora.push_back(std::move(corpus));
+    }
+    corpora.push_back({"edge", 0, 0, ExpressionGenerator(0).generateEdgeCases()});
+    return corpora;
+}
+
+// 重复整趟执行 pass 直到累计时间超过 minTime，返回每趟的平均秒数
+template <typename Pass>
+static double timePasses(Pass pass, double minTime, size_t &passes)
+{
+    pass(); // 预热
+    passes = 0;
+    auto start = Clock::now();
+    double total = 0;
+    do
+    {
+        pass();
+        ++passes;
+        total = elapsed(start);
+    } while (total < minTime);
+    return total / passes;
+}
+
+// 对每个元素单独计时，返回排好序的 ns 数组
+template <typename Call>
+static std::vector<double> timeCalls(size_t n, Call call)
+{
+    std::vector<double> ns(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        auto start = Clock::now();
+        call(i);
+        ns[i] = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+    std::sort(ns.begin(), ns.end());
+    return ns;
+}
+
+static double percentile(const std::vector<double> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+template <typename Call>
+static PhaseResult measure(const Corpus &corpus, const char *phase, size_t bytes, double minTime, Call call)
+{
+    PhaseResult r;
+    r.corpus = corpus.name;
+    r.phase = phase;
+    r.items = corpus.texts.size();
+    r.bytes = bytes;
+    double sec = timePasses([&] {
+        for (size_t i = 0; i < r.items; ++i)
+            call(i);
+    }, minTime, r.passes);
+    r.itemsPerSec = r.items / sec;
+    r.mbPerSec = bytes / sec / 1e6;
+    std::vector<double> ns = timeCalls(r.items, call);
+    r.p50 = percentile(ns, 0.5);
+    r.p90 = percentile(ns, 0.9);
+    r.p99 = percentile(ns, 0.99);
+    r.max = ns.empty() ? 0 : ns.back();
+    return r;
+}
+
+// 防止被测结果被优化掉
+static volatile size_t gSink;
+
+static void runCorpus(const Corpus &corpus, double minTime, std::vector<PhaseResult> &results)
+{
+    size_t n = corpus.texts.size();
+    size_t bytes = 0;
+    for (const std::string &text : corpus.texts)
+        bytes += text.size();
+
+    std::vector<TokenBuffer> tokens(n);
+    std::vector<std::shared_ptr<ASTNode>> asts(n), copies(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        tokens[i] = Lexer(corpus.texts[i]).tokenize();
+        asts[i] = Parser(tokens[i]).parse();
+        TokenBuffer again = Lexer(corpus.texts[i]).tokenize();
+        copies[i] = Parser(again).parse();
+    }
+
+    results.push_back(measure(corpus, "tokenize", bytes, minTime, [&](size_t i) {
+        gSink = Lexer(corpus.texts[i]).tokenize().size();
+    }));
+    results.push_back(measure(corpus, "parse", bytes, minTime, [&](size_t i) {
+        gSink = Parser(tokens[i]).parse() != nullptr;
+    }));
+    results.push_back(measure(corpus, "standardize", bytes, minTime, [&](size_t i) {
+        gSink = EqualityChecker::standardize(asts[i]).size();
+    }));
+    results.push_back(measure(corpus, "areEqual", bytes * 2, minTime, [&](size_t i) {
+        gSink = EqualityChecker::areEqual(asts[i], copies[i]);
+    }));
+}
+
+static std::string jsonEscape(const std::string &text)
+{
+    std::string out;
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+static void writeText(FILE *out, const std::vector<PhaseResult> &results)
+{
+    std::fprintf(out, "%-8s %-12s %6s %12s %9s %10s %10s %10s %10s\n", "corpus", "phase", "items", "items/s",
+                 "MB/s", "p50 ns", "p90 ns", "p99 ns", "max ns");
+    for (const PhaseResult &r : results)
+    {
+        std::fprintf(out, "%-8s %-12s %6zu %12.0f %9.1f %10.0f %10.0f %10.0f %10.0f\n", r.corpus.c_str(),
+                     r.phase.c_str(), r.items, r.itemsPerSec, r.mbPerSec, r.p50, r.p90, r.p99, r.max);
+    }
+}
+
+static void writeCsv(FILE *out, const std::vector<PhaseResult> &results)
+{
+    std::fprintf(out, "corpus,phase,items,bytes,passes,items_per_sec,mb_per_sec,p50_ns,p90_ns,p99_ns,max_ns\n");
+    for (const PhaseResult &r : results)
+    {
+        std::fprintf(out, "%s,%s,%zu,%zu,%zu,%.1f,%.3f,%.1f,%.1f,%.1f,%.1f\n", r.corpus.c_str(), r.phase.c_str(),
+                     r.items, r.bytes, r.passes, r.itemsPerSec, r.mbPerSec, r.p50, r.p90, r.p99, r.max);
+    }
+}
+
+static void writeJson(FILE *out, const std::vector<Corpus> &corpora, const std::vector<PhaseResult> &results)
+{
+    std::fprintf(out, "{\n  \"schema\": 1,\n");
+#ifdef __VERSION__
+    std::fprintf(out, "  \"compiler\": \"%s\",\n", jsonEscape(__VERSION__).c_str());
+#endif
+    std::fprintf(out, "  \"corpora\": [\n");
+    for (size_t i = 0; i < corpora.size(); ++i)
+    {
+        std::fprintf(out, "    {\"name\": \"%s\", \"seed\": %u, \"max_depth\": %d, \"items\": %zu}%s\n",
+                     corpora[i].name.c_str(), corpora[i].seed, corpora[i].maxDepth, corpora[i].texts.size(),
+                     i + 1 < corpora.size() ? "," : "");
+    }
+    std::fprintf(out, "  ],\n  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const PhaseResult &r = results[i];
+        std::fprintf(out,
+                     "    {\"corpus\": \"%s\", \"phase\": \"%s\", \"items\": %zu, \"bytes\": %zu, \"passes\": %zu, "
+                     "\"items_per_sec\": %.1f, \"mb_per_sec\": %.3f, \"p50_ns\": %.1f, \"p90_ns\": %.1f, "
+                     "\"p99_ns\": %.1f, \"max_ns\": %.1f}%s\n",
+                     r.corpus.c_str(), r.phase.c_str(), r.items, r.bytes, r.passes, r.itemsPerSec, r.mbPerSec, r.p50,
+                     r.p90, r.p99, r.max, i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+}
+
+int main(int argc, char *argv[])
+{
+    std::string format = "text";
+    const char *outPath = nullptr;
+    double minTime = 0.2;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+            format = argv[++i];
+        else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+            outPath = argv[++i];
+        else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+            minTime = std::atof(argv[++i]);
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--format text|json|csv] [--out file] [--min-time seconds]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (format != "text" && format != "json" && format != "csv")
+    {
+        std::fprintf(stderr, "unknown format: %s\n", format.c_str());
+        return 2;
+    }
+
+    std::vector<Corpus> corpora = buildCorpora();
+    std::vector<PhaseResult> results;
+    try
+    {
+        for (const Corpus &corpus : corpora)
+            runCorpus(corpus, minTime, results);
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "benchmark failed: %s\n", e.what());
+        return 1;
+    }
+
+    FILE *out = outPath ? std::fopen(outPath, "w") : stdout;
+    if (!out)
+    {
+        std::fprintf(stderr, "cannot open %s\n", outPath);
+        return 1;
+    }
+    if (format == "json")
+        writeJson(out, corpora, results);
+    else if (format == "csv")
+        writeCsv(out, results);
+    else
+        writeText(out, results);
+    if (out != stdout)
+        std::fclose(out);
+    return 0;
+}
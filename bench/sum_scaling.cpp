@@ -0,0 +1,63 @@
+/**
+ * @file sum_scaling.cpp
+ * @brief Benchmark: standardize() time on long left-associative sums a1 + a2 + ... + an.
+ *
+ * Each summand is a product of three single-letter variables (e.g. "a*b*C"), so up to
+ * 52^3 summands are pairwise distinct monomials. The sum is parsed once and only
+ * EqualityChecker::standardize is timed. Near-linear scaling shows up as a flat ns/term.
+ *
+ * The tree is as deep as the sum is long; standardize() switches to an explicit stack past a
+ * fixed depth, so this runs on the main thread with the default stack size.
+ *
+ * Build (from the project root):
+ *   make bench/sum_scaling
+ * Run:
+ *   ./bench/sum_scaling [maxTerms]      (default 100000)
+ */
+#include "Lexer.h"
+#include "Parser.h"
+#include "EqualityChecker.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+static const char kLetters[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+static std::string makeSum(size_t n)
+{
+    std::string text;
+    text.reserve(n * 8);
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (i > 0)
+            text += " + ";
+        // 显式乘号，避免相邻字母拼成 sin / ln 等关键字
+        text += kLetters[i % 52];
+        text += '*';
+        text += kLetters[(i / 52) % 52];
+        text += '*';
+        text += kLetters[(i / 2704) % 52];
+    }
+    return text;
+}
+
+int main(int argc, char **argv)
+{
+    size_t maxTerms = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+
+    std::printf("%10s %12s %12s %10s\n", "terms", "result", "ms", "ns/term");
+    for (size_t n = 1000; n <= maxTerms; n *= 10)
+    {
+        std::string text = makeSum(n);
+        Lexer lexer(text);
+        TokenBuffer tokens = lexer.tokenize();
+        Parser parser(tokens);
+        auto ast = parser.parse();
+
+        auto start = std::chrono::steady_clock::now();
+        auto poly = EqualityChecker::standardize(ast);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%10zu %12zu %12.2f %10.1f\n", n, poly.size(), seconds * 1e3, seconds * 1e9 / n);
+    }
+    return 0;
+}
@@ -5,9 +5,16 @@
 #include <string>
 #include <vector>
 #include <random>
+#include <cstdint>
+#include <cstdio>
 #include <ctime>
 #include <functional>
 
+// generateSized 的形状：深层嵌套、宽和式、幂塔
+enum class Shape { Deep, Wide, Tower };
+// generateSized 的目标单位：字节数或语法树结点数
+enum class SizeUnit { Bytes, Nodes };
+
 class ExpressionGenerator {
 private:
     std::mt19937 rng;
@@ -34,11 +41,131 @@ private:
         return list[randomInt(0, list.size() - 1)];
     }
 
+    // generateSized 的输出端：追加到 buffer，给了 stream 时每满 64 KB 写出一次，
+    // 同时统计已输出的字节数和语法树结点数
+    struct SizedWriter {
+        std::string& buffer;
+        std::ostream* stream;
+        size_t bytes = 0;
+        size_t nodes = 0;
+
+        void put(const std::string& text) { put(text.data(), text.size()); }
+        void put(const char* text, size_t length) {
+            buffer.append(text, length);
+            bytes += length;
+            if (stream && buffer.size() >= (1 << 16)) flush();
+        }
+        void flush() {
+            if (!stream) return;
+            stream->write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    };
+
+    void putAtom(SizedWriter& out) {
+        char digits[16];
+        if (randomDouble() < 0.6) {
+            int length = std::snprintf(digits, sizeof digits, "%d", randomInt(0, 100));
+            out.put(digits, length);
+        } else {
+            out.put(randomChoice(vars));
+        }
+        ++out.nodes;
+    }
+
+    // 剩余预算：按字节计时预留 reserve 个字节给尚未输出的收尾部分
+    static bool reached(const SizedWriter& out, size_t target, SizeUnit unit, size_t reserve) {
+        return unit == SizeUnit::Bytes ? out.bytes + reserve >= target : out.nodes + 1 >= target;
+    }
+
+    // 深层嵌套：括号、函数、一元负号和“原子 op (”不断向内嵌套，最后统一补上右括号
+    void sizedDeep(SizedWriter& out, size_t target, SizeUnit unit) {
+        size_t closers = 0;
+        while (!reached(out, target, unit, closers + 3)) {
+            double p = randomDouble();
+            if (p < 0.25) {
+                out.put("(", 1);
+            } else if (p < 0.5) {
+                out.put(randomChoice(funcs));
+                out.put("(", 1);
+                ++out.nodes;
+            } else if (p < 0.6) {
+                out.put("-", 1);
+                ++out.nodes;
+                continue; // 不需要右括号
+            } else {
+                putAtom(out);
+                out.put(" ", 1);
+                out.put(randomChoice(ops));
+                out.put(" (", 2);
+                ++out.nodes;
+            }
+            ++closers;
+        }
+        putAtom(out);
+        for (; closers > 0; --closers) out.put(")", 1);
+    }
+
+    // 宽：很长的和式，每一项是系数与一到三个变量的乘积（部分用隐式乘法）
+    void sizedWide(SizedWriter& out, size_t target, SizeUnit unit) {
+        bool first = true;
+        do {
+            if (!first) {
+                out.put(randomDouble() < 0.7 ? " + " : " - ", 3);
+                ++out.nodes;
+            }
+            first = false;
+            int factors = randomInt(1, 3);
+            putAtom(out);
+            for (int i = 1; i < factors; ++i) {
+                if (randomDouble() < 0.5) out.put(" * ", 3);
+                out.put(randomChoice(vars));
+                out.nodes += 2;
+            }
+        } while (!reached(out, target, unit, 0));
+    }
+
+    // 幂塔：右结合的 a ^ b ^ c ^ ...，偶尔以括号中的和作为底数
+    void sizedTower(SizedWriter& out, size_t target, SizeUnit unit) {
+        bool first = true;
+        do {
+            if (!first) {
+                out.put(" ^ ", 3);
+                ++out.nodes;
+            }
+            first = false;
+            if (randomDouble() < 0.2) {
+                out.put("(", 1);
+                putAtom(out);
+                out.put(" + ", 3);
+                putAtom(out);
+                out.put(")", 1);
+                ++out.nodes;
+            } else {
+                putAtom(out);
+            }
+        } while (!reached(out, target, unit, 0));
+    }
+
+    void generateSized(SizedWriter& out, size_t target, Shape shape, SizeUnit unit) {
+        switch (shape) {
+            case Shape::Deep: sizedDeep(out, target, unit); break;
+            case Shape::Wide: sizedWide(out, target, unit); break;
+            case Shape::Tower: sizedTower(out, target, unit); break;
+        }
+        out.flush();
+    }
+
 public:
     ExpressionGenerator() {
         rng.seed(std::time(nullptr));
     }
 
+    // 固定种子：同一种子在同一标准库实现下生成相同的表达式序列（用于可复现的基准测试）
+    explicit ExpressionGenerator(std::uint32_t seed) {
+        rng.seed(seed);
+    }
+
     // 生成基础数值或变量
     std::string generateAtom() {
         if (randomDouble() < 0.6) {
@@ -86,6 +213,20 @@ public:
         }
     }
 
+    // 按目标规模生成表达式，直接写入输出，用时与输出长度成线性（不做递归，也不拼接子串）。
+    // 结果大小约为 target 字节或 target 个结点（最后一个原子可能略微超出）；种子相同则结果相同
+    void generateSized(std::string& out, size_t target, Shape shape, SizeUnit unit = SizeUnit::Bytes) {
+        SizedWriter writer{out, nullptr};
+        generateSized(writer, target, shape, unit);
+    }
+
+    // 写入流，内部只保留约 64 KB 的缓冲区
+    void generateSized(std::ostream& os, size_t target, Shape shape, SizeUnit unit = SizeUnit::Bytes) {
+        std::string buffer;
+        SizedWriter writer{buffer, &os};
+        generateSized(writer, target, shape, unit);
+    }
+
     // 生成特定类型的边缘测试用例
     std::vector<std::string> generateEdgeCases() {
         return {
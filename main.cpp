@@ -11,38 +11,52 @@
 #include "Parser.h"
 #include "exam.h"
 #include "EqualityChecker.h"
+#include "BatchRunner.h"
+#include "CanonCache.h"
+#include "BufferedWriter.h"
+#include "PerfStats.h"
+#include <ctype.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <chrono>
+#include <fstream>
 #include <iostream>
 #include <limits>
+#include <memory>
 using namespace std;
 
 // choose whether to enable random_test
 #define ENABLE_RANDOM_TEST
 
+// 逐个输出 Token；用 '\n' 而不是 endl，避免每个 Token 刷新一次
+void printTokens(ostream &out, const TokenBuffer &tokens)
+{
+    out << "--- Tokens --- " << '\n';
+    for (size_t i = 0; i < tokens.size(); ++i)
+    {
+        out << tokens[i].toString() << " " << '\n';
+    }
+}
+
 shared_ptr<ASTNode> genTokensAST(string expr)
 {
     Lexer lexer(expr);
-    vector<Token> tokens = lexer.tokenize();
+    TokenBuffer tokens = lexer.tokenize();
     // Lexical Analysis
-    cout << "--- Tokens --- " << endl;
-    for (const auto &token : tokens)
-    {
-        cout << token.toString() << " ";
-        cout << endl;
-    }
+    printTokens(cout, tokens);
     // Syntax Analysis(Parsing)
     Parser parser(tokens);
     shared_ptr<ASTNode> ast = parser.parse();
 
-    cout << "--- Abstract Syntax Tree (AST) ---" << endl;
+    cout << "--- Abstract Syntax Tree (AST) ---" << '\n';
     if (ast)
     {
-        ast->print(0);
-        cout << "--- Standardized Form (SOP) ---" << endl;
+        ast->print(cout, 0);
+        cout << "--- Standardized Form (SOP) ---" << '\n';
         string stdStr1 = EqualityChecker::getStandardizedString(ast);
-        cout << stdStr1 << endl;
+        cout << stdStr1 << '\n';
     }
     return ast;
 }
@@ -55,6 +69,8 @@ void compare(string expr1, string expr2)
         shared_ptr<ASTNode> ast1 = genTokensAST(expr1);
         shared_ptr<ASTNode> ast2 = genTokensAST(expr2);
 
+        cout << "Standardized expressions: " << EqualityChecker::getStandardizedString(ast1) << " and "
+             << EqualityChecker::getStandardizedString(ast2) << endl;
         if (EqualityChecker::areEqual(ast1, ast2))
         {
             cout << "The two expressions are equal." << endl;
@@ -70,8 +86,253 @@ void compare(string expr1, string expr2)
     }
 }
 
-int main()
+// 命令行模式的选项
+struct CliOptions
+{
+    string mode;   // --canon / --compare / --batch
+    string path;   // 为空或 "-" 时读 stdin
+    unsigned threads = 0;
+    bool random = false;
+    int verbosity = 0; // 0：只输出结果；1 (-v)：加上语法树/标准化形式与耗时；2 (-vv)：再加上 Token
+    string stats;      // 为空时不统计；"text" / "json"：结束后向 stderr 输出各阶段计数
+    string cache;      // 为空时不使用；否则为规范形式缓存文件，结束时写回
+    bool fingerprint = false; // --canon 输出 128 位指纹而不是规范形式
+};
+
+void printUsage(const char *prog)
+{
+    cerr << "Usage:\n"
+         << "  " << prog << " --canon [file] [--fingerprint] [-v|-vv]\n"
+         << "      one expression per line, prints its canonical form (or its 128-bit fingerprint)\n"
+         << "  " << prog << " --compare [file] [--threads N] [--random] [-v]\n"
+         << "  " << prog << " --batch <file> [--threads N] [--random] [-v]\n"
+         << "      one 'expr1, expr2' pair per line, prints the verdicts in input order\n"
+         << "Input is read from stdin when no file (or '-') is given.\n"
+         << "--stats[=json] prints per-phase counters to stderr at exit (with -v, also per pair).\n"
+         << "--threads N takes a positive integer; without it every hardware thread is used.\n"
+         << "--cache FILE reuses canonical forms stored in FILE and adds new ones to it at exit.\n";
+}
+
+bool parseOptions(int argc, char *argv[], CliOptions &opt)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--canon" || arg == "--compare" || arg == "--batch")
+        {
+            opt.mode = arg;
+            if (i + 1 < argc && (argv[i + 1][0] != '-' || string(argv[i + 1]) == "-"))
+                opt.path = argv[++i];
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            // 只接受正整数；负数、0、非数字或超出范围都按用法错误处理
+            const char *text = argv[++i];
+            char *end = nullptr;
+            errno = 0;
+            unsigned long n = isdigit(static_cast<unsigned char>(text[0])) ? strtoul(text, &end, 10) : 0;
+            if (n == 0 || *end != '\0' || errno == ERANGE || n > numeric_limits<unsigned>::max())
+                return false;
+            opt.threads = static_cast<unsigned>(n);
+        }
+        else if (arg == "--random")
+            opt.random = true;
+        else if (arg == "-v")
+            opt.verbosity = max(opt.verbosity, 1);
+        else if (arg == "-vv")
+            opt.verbosity = 2;
+        else if (arg == "--stats" || arg == "--stats=text")
+            opt.stats = "text";
+        else if (arg == "--stats=json")
+            opt.stats = "json";
+        else if (arg == "--fingerprint")
+            opt.fingerprint = true;
+        else if (arg == "--cache" && i + 1 < argc)
+            opt.cache = argv[++i];
+        else
+            return false;
+    }
+    return !opt.mode.empty() && !(opt.mode == "--batch" && opt.path.empty());
+}
+
+// 每行一个表达式，输出其标准化形式（或指纹）；出错的行输出 "error: ..."
+void runCanon(istream &in, ostream &out, const CliOptions &opt, CanonCache *cache)
 {
+    int verbosity = opt.verbosity;
+    AstArena arena;
+    string line;
+    while (getline(in, line))
+    {
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == string::npos)
+            continue;
+        try
+        {
+            if (verbosity == 0 && opt.fingerprint)
+            {
+                // 只需要指纹，不生成文本，也不使用缓存
+                arena.clear();
+                Lexer lexer(line);
+                Parser parser(lexer);
+                NodeId root = parser.parse(arena);
+                out << EqualityChecker::getFingerprint(arena, root).toString() << '\n';
+                continue;
+            }
+            if (verbosity == 0)
+            {
+                // 缓存的键是去掉首尾空白的文本
+                string_view key = string_view(line).substr(first, line.find_last_not_of(" \t\r") + 1 - first);
+                string_view cached;
+                if (cache && cache->lookup(key, cached))
+                {
+                    out << cached << '\n';
+                    continue;
+                }
+                // 静默模式：流式解析到复用的 arena，不生成 Token 序列和指针树
+                arena.clear();
+                Lexer lexer(line);
+                Parser parser(lexer);
+                NodeId root = parser.parse(arena);
+                string canonical = EqualityChecker::getStandardizedString(arena, root);
+                if (cache)
+                    cache->insert(key, canonical);
+                out << canonical << '\n';
+                continue;
+            }
+            Lexer lexer(line);
+            TokenBuffer tokens = lexer.tokenize();
+            if (verbosity >= 2)
+                printTokens(out, tokens);
+            Parser parser(tokens);
+            shared_ptr<ASTNode> ast = parser.parse();
+            out << "--- Abstract Syntax Tree (AST) ---" << '\n';
+            if (ast)
+                ast->print(out, 0);
+            out << "--- Standardized Form (SOP) ---" << '\n';
+            out << EqualityChecker::getStandardizedString(ast) << '\n';
+            if (opt.fingerprint)
+                out << "--- Fingerprint ---" << '\n' << EqualityChecker::getFingerprint(ast).toString() << '\n';
+        }
+        catch (const std::exception &err)
+        {
+            out << "error: " << err.what() << '\n';
+        }
+    }
+}
+
+// 多线程比较表达式对，按输入顺序输出结论
+void runCompare(istream &in, ostream &out, const CliOptions &opt, CanonCache *cache)
+{
+    vector<ExpressionPair> pairs = BatchRunner::readPairs(in);
+    BatchRunner runner(opt.random ? BatchRunner::Mode::Probabilistic : BatchRunner::Mode::Exact);
+    runner.setCache(cache);
+    auto start = chrono::steady_clock::now();
+    vector<PairResult> results = runner.run(pairs, opt.threads);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    for (size_t i = 0; i < pairs.size(); ++i)
+    {
+        const PairResult &r = results[i];
+        out << pairs[i].line << ": ";
+        if (!r.ok)
+            out << "error: " << r.error;
+        else if (r.verdict == EqualityVerdict::Different)
+            out << "not equal";
+        else if (r.verdict == EqualityVerdict::ProbablyEqual)
+            out << "probably equal";
+        else
+            out << "equal";
+        if (r.ok && opt.verbosity >= 1)
+        {
+            // 附上两边的标准化形式（额外解析一次，仅在 -v 时）
+            AstArena left, right;
+            Lexer lexer1(pairs[i].left), lexer2(pairs[i].right);
+            Parser parser1(lexer1), parser2(lexer2);
+            NodeId root1 = parser1.parse(left), root2 = parser2.parse(right);
+            out << "  [" << EqualityChecker::getStandardizedString(left, root1) << " | "
+                << EqualityChecker::getStandardizedString(right, root2) << "]";
+        }
+        if (!opt.stats.empty() && opt.verbosity >= 1)
+        {
+            // 解析与标准化两个阶段互不包含，相加即这一对的耗时
+            const PerfCounters &s = r.stats;
+            double micros = (s.nanos[size_t(Phase::Parse)] + s.nanos[size_t(Phase::Standardize)]) / 1e3;
+            out << "  {tokens " << s.tokens << ", nodes " << s.astNodes << ", opaque " << s.opaqueAtoms << ", peak terms "
+                << s.peakTerms << ", allocs " << s.allocations << ", " << micros << " us}";
+        }
+        out << '\n';
+    }
+    if (opt.verbosity >= 1)
+    {
+        cerr << pairs.size() << " pairs in " << seconds * 1e3 << " ms ("
+             << (seconds > 0 ? pairs.size() / seconds : 0) << " pairs/s)" << endl;
+    }
+}
+
+// 非交互的命令行模式：不运行随机测试，结果经由大缓冲区输出
+int runCli(int argc, char *argv[])
+{
+    CliOptions opt;
+    if (!parseOptions(argc, argv, opt))
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+    ios::sync_with_stdio(false);
+    ifstream file;
+    if (!opt.path.empty() && opt.path != "-")
+    {
+        file.open(opt.path);
+        if (!file)
+        {
+            cerr << "Cannot open " << opt.path << endl;
+            return 1;
+        }
+    }
+    istream &in = file.is_open() ? static_cast<istream &>(file) : cin;
+
+    PerfStats::setEnabled(!opt.stats.empty());
+    unique_ptr<CanonCache> cache;
+    if (!opt.cache.empty())
+        cache = make_unique<CanonCache>(opt.cache);
+    BufferedWriter writer(stdout);
+    ostream out(&writer);
+    if (opt.mode == "--canon")
+        runCanon(in, out, opt, cache.get());
+    else
+        runCompare(in, out, opt, cache.get());
+    out.flush();
+    if (cache)
+    {
+        if (opt.verbosity >= 1)
+        {
+            cerr << "cache: " << cache->hits() << " hits, " << cache->misses() << " misses, "
+                 << cache->mappedEntries() << " + " << cache->pendingEntries() << " entries" << endl;
+        }
+        try
+        {
+            cache->save();
+        }
+        catch (const std::exception &err)
+        {
+            cerr << err.what() << endl;
+        }
+    }
+    if (opt.stats == "json")
+    {
+        PerfStats::process().printJson(cerr);
+        cerr << endl;
+    }
+    else if (opt.stats == "text")
+        PerfStats::process().print(cerr);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1)
+        return runCli(argc, argv);
+
 #ifdef ENABLE_RANDOM_TEST
     // generate expr randomly
     ExpressionGenerator generator;